@@ -0,0 +1,52 @@
+// File:    aligned_allocator.hpp
+// Allocator for std::vector whose elements must start on a cache line.
+// With -std=c++11 operator new ignores alignas() beyond alignof(max_align_t),
+// so per-thread blocks in a plain std::vector may still share cache lines.
+
+#ifndef UTIL_ALIGNED_ALLOCATOR_HEADER
+#define UTIL_ALIGNED_ALLOCATOR_HEADER
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace util {
+
+    static const std::size_t cacheline = 64;
+
+    template <class T, std::size_t Alignment = cacheline>
+    struct aligned_allocator {
+        using value_type = T;
+
+        template <class U>
+        struct rebind {
+            using other = aligned_allocator<U, Alignment>;
+        };
+
+        aligned_allocator() noexcept {}
+        template <class U>
+        aligned_allocator(aligned_allocator<U, Alignment> const &) noexcept {}
+
+        T* allocate(std::size_t n) {
+            void* p = nullptr;
+            if(posix_memalign(&p, Alignment, n * sizeof(T)) != 0)
+                throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+        void deallocate(T* p, std::size_t) noexcept {
+            std::free(p);
+        }
+    };
+
+    template <class T, class U, std::size_t A>
+    inline bool operator==(aligned_allocator<T, A> const &, aligned_allocator<U, A> const &) {
+        return true;
+    }
+    template <class T, class U, std::size_t A>
+    inline bool operator!=(aligned_allocator<T, A> const &, aligned_allocator<U, A> const &) {
+        return false;
+    }
+
+} // end namespace util
+
+#endif // UTIL_ALIGNED_ALLOCATOR_HEADER
@@ -1,18 +1,30 @@
 #include "analysis.hpp"
 
 
+#include <chrono>
 #include <ctime>
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <cstdlib>
 #include <limits.h>
 #include <unistd.h>
+#include <sys/resource.h>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <sqlite3.h>
 
 
+static std::string getHostname(){
+    char hostname[HOST_NAME_MAX];
+    int result = gethostname(hostname, HOST_NAME_MAX);
+    if (result)
+      return "Unk";
+    return std::string(hostname);
+}
+
 std::string analysis::suggestBaseFilename(){
     std::string sep = "_";
     #ifdef OPTIMISTIC
@@ -27,13 +39,7 @@ std::string analysis::suggestBaseFilename(){
     std::string an = "0";
     #endif
 
-    std::string env_host;
-    char hostname[HOST_NAME_MAX];
-    int result = gethostname(hostname, HOST_NAME_MAX);
-    if (result)
-      env_host = "Unk";
-    else
-      env_host = std::string(hostname);
+    std::string env_host = getHostname();
 
 
     std::stringstream ss;
@@ -50,14 +56,75 @@ std::string analysis::suggestBaseFilename(){
     return ss.str();
 }
 
+// Value of a "Vm...:  <n> kB" line of /proc/self/status in bytes, 0 if not available
+static analysis::type_size procStatus(const std::string& key){
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)){
+        if(line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':')
+            return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10) * 1024;
+    }
+    return 0;
+}
+
+// Sum of the recorded data structures
+static analysis::type_size structureBytes(const analysis::type_memorymap& memory){
+    analysis::type_size sum = 0;
+    for(const auto& mem : memory)
+        sum += mem.second;
+    return sum;
+}
+
+void analysis::startmemory(){
+    rssBefore_ = procStatus("VmRSS");
+    // reset the high water mark to the current RSS, so the peak belongs to this sort
+    // (needs Linux 4.0, else the peak includes everything since the process started)
+    std::ofstream clear("/proc/self/clear_refs");
+    if(clear) clear << "5";
+}
+
+void analysis::stopmemory(){
+    peakRSS_ = procStatus("VmHWM");
+    if(peakRSS_ == 0){
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) == 0)
+            peakRSS_ = static_cast<type_size>(usage.ru_maxrss) * 1024;
+    }
+}
+
+#if ENABLE_ANALYSIS == 1
+// Seconds per time stamp counter tick, measured once against the steady clock
+static double secondsPerTick(){
+    static const double spt = [](){
+        auto t0 = std::chrono::steady_clock::now();
+        analysis::type_ticks c0 = analysis::ticks();
+        while(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20));
+        analysis::type_ticks c1 = analysis::ticks();
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        return dt.count() / (c1 - c0);
+    }();
+    return spt;
+}
+
+void analysis::reduce(){
+    const double spt = secondsPerTick();
+    for(type_threadcount i = 0; i < nThreads_; ++i){
+        const threadblock& tb = threadblocks_[i];
+        count_ProcessedNodes_[i] = tb.processedNodes_;
+        count_ProcessedEdges_[i] = tb.processedEdges_;
+        count_Prefetches_[i] = tb.prefetches_;
+        for(int c = 0; c < N_TIMECAT; ++c){
+            // extrapolate from the sampled calls
+            type_ticks nSampled = (tb.calls_[c] + samplemask_) >> ANALYSIS_SAMPLESHIFT;
+            double scale = nSampled > 0 ? static_cast<double>(tb.calls_[c]) / nSampled : 0.;
+            timings_[c][i] = tb.ticks_[c] * spt * scale;
+        }
+    }
+}
+#endif // ENABLE_ANALYSIS == 1
+
 bool analysis::xmlAnalysis(std::string relativeDir){
-    std::string env_host;
-    char hostname[HOST_NAME_MAX];
-    int result = gethostname(hostname, HOST_NAME_MAX);
-    if (result)
-      env_host = "Unk";
-    else
-      env_host = std::string(hostname);
+    std::string env_host = getHostname();
     
 
 	// Boost: create directory if it doesn't exist yet
@@ -80,6 +147,39 @@ bool analysis::xmlAnalysis(std::string relativeDir){
     output << "\t\t<totalTime>" << time_Total_ << "</totalTime>\n";
     output << "\t\t<algorithm>" << algorithmName_ << "</algorithm>\n";
     
+    // disk traffic (only out-of-core engines do I/O while sorting)
+    if(ioBytesRead_ + ioBytesWritten_ > 0){
+        output << "\t\t<io>\n";
+        output << "\t\t\t<bytesRead>" << ioBytesRead_ << "</bytesRead>\n";
+        output << "\t\t\t<bytesWritten>" << ioBytesWritten_ << "</bytesWritten>\n";
+        output << "\t\t\t<readTime>" << time_IORead_ << "</readTime>\n";
+        output << "\t\t\t<writeTime>" << time_IOWrite_ << "</writeTime>\n";
+        output << "\t\t</io>\n";
+    }
+    
+    if(!parameters_.empty()){
+        output << "\t\t<parameters>\n";
+        for(const auto& par : parameters_)
+            output << "\t\t\t<parameter name=\"" << par.first << "\">" << par.second << "</parameter>\n";
+        output << "\t\t</parameters>\n";
+    }
+    
+    // resident set and the recorded data structures, per node and edge of the graph
+    {
+        const type_size structures = structureBytes(memory_);
+        output << "\t\t<memory>\n";
+        output << "\t\t\t<rssBefore>" << rssBefore_ << "</rssBefore>\n";
+        output << "\t\t\t<peakRSS>" << peakRSS_ << "</peakRSS>\n";
+        for(const auto& mem : memory_)
+            output << "\t\t\t<structure name=\"" << mem.first << "\">" << mem.second << "</structure>\n";
+        output << "\t\t\t<structureBytes>" << structures << "</structureBytes>\n";
+        output << "\t\t\t<bytesPerNode>" << (nNodes_ > 0 ? static_cast<double>(structures) / nNodes_ : 0.) << "</bytesPerNode>\n";
+        output << "\t\t\t<bytesPerEdge>" << (nEdges_ > 0 ? static_cast<double>(structures) / nEdges_ : 0.) << "</bytesPerEdge>\n";
+        output << "\t\t\t<peakRSSPerNode>" << (nNodes_ > 0 ? static_cast<double>(peakRSS_) / nNodes_ : 0.) << "</peakRSSPerNode>\n";
+        output << "\t\t\t<peakRSSPerEdge>" << (nEdges_ > 0 ? static_cast<double>(peakRSS_) / nEdges_ : 0.) << "</peakRSSPerEdge>\n";
+        output << "\t\t</memory>\n";
+    }
+    
     #if ENABLE_ANALYSIS == 1
     // in-depth analysis
     output << "\t\t<threads>\n";
@@ -95,6 +195,27 @@ bool analysis::xmlAnalysis(std::string relativeDir){
         output << "\t\t\t</timings>\n";
         output << "\t\t\t<processedNodes>" << count_ProcessedNodes_[i] << "</processedNodes>\n";
         output << "\t\t\t<processedEdges>" << count_ProcessedEdges_[i] << "</processedEdges>\n";
+        output << "\t\t\t<prefetches>" << count_Prefetches_[i] << "</prefetches>\n";
+        #if ENABLE_PERFCOUNTERS == 1
+        // hardware counters per time category and for the whole sort
+        const char* phaseNames[N_TIMECAT] = {"barrier", "criticalPushBack", "criticalRequestValueUpdate", "currentGather", "currentScatter"};
+        const threadblock& tb = threadblocks_[i];
+        output << "\t\t\t<counters available=\"" << (tb.perf_ && tb.perf_->valid() ? "true" : "false") << "\">\n";
+        for(int c = 0; c <= N_TIMECAT; ++c){
+            const type_perfvalues& v = (c < N_TIMECAT) ? tb.perfPhases_[c] : tb.perfThread_;
+            output << "\t\t\t\t<phase name=\"" << (c < N_TIMECAT ? phaseNames[c] : "total") << "\">";
+            output << "<cycles>" << v.v[util::CYCLES] << "</cycles>";
+            output << "<instructions>" << v.v[util::INSTRUCTIONS] << "</instructions>";
+            output << "<llcMisses>" << v.v[util::LLCMISSES] << "</llcMisses>";
+            output << "<dtlbMisses>" << v.v[util::DTLBMISSES] << "</dtlbMisses>";
+            output << "<branchMisses>" << v.v[util::BRANCHMISSES] << "</branchMisses>";
+            output << "<ipc>" << v.ipc() << "</ipc>";
+            if(c == N_TIMECAT && count_ProcessedEdges_[i] > 0) // one cache line per last level miss
+                output << "<bytesPerEdge>" << 64. * v.v[util::LLCMISSES] / count_ProcessedEdges_[i] << "</bytesPerEdge>";
+            output << "</phase>\n";
+        }
+        output << "\t\t\t</counters>\n";
+        #endif
         output << "\t\t\t</thread>\n";
     }
     output << "\t\t</threads>\n";
@@ -183,5 +304,137 @@ bool analysis::xmlAnalysis(std::string relativeDir){
     }
     
     std::cout << "Analysis written to: " << filename << std::endl;
+
+    // timeline and per-level statistics next to the analysis file
+    #if ENABLE_TRACE == 1
+    std::string traceBase = filename.substr(0, filename.size() - 4);
+    tracer_.writeChromeTrace(traceBase + ".trace.json");
+    tracer_.writeLevelStatistics(traceBase + ".levels.csv");
+    #endif
     return true;
 }
+
+
+// Schema of measurements/measurements.db, as queried by the plot scripts
+static const char* sqliteSchema =
+    "CREATE TABLE IF NOT EXISTS `parameters` (\t`id`\tINTEGER PRIMARY KEY AUTOINCREMENT,\t`measurement_id`\tINTEGER,\t`name`\tTEXT,\t`value`\tREAL);"
+    "CREATE TABLE IF NOT EXISTS `memory` (\t`id`\tINTEGER PRIMARY KEY AUTOINCREMENT,\t`measurement_id`\tINTEGER,\t`name`\tTEXT,\t`bytes`\tREAL);"
+    "CREATE TABLE IF NOT EXISTS `timings` (\t`id`\tINTEGER PRIMARY KEY AUTOINCREMENT,\t`thread_id`\tINTEGER,\t`name`\tTEXT,\t`value`\tREAL);"
+    "CREATE TABLE IF NOT EXISTS \"threads\" (\t`id`\tINTEGER PRIMARY KEY AUTOINCREMENT,\t`measurement_id`\tINTEGER,\t`thread_id`\tINTEGER,\t`processed_nodes`\tINTEGER, `processed_edges`\tINTEGER);"
+    "CREATE TABLE IF NOT EXISTS \"measurements\" (\t`id`\tINTEGER PRIMARY KEY AUTOINCREMENT,\t`date`\tBLOB,\t`number_of_threads`\tBLOB,\t`processors`\tTEXT,\t`comment`\tNUMERIC,\t`total_time`\tREAL,\t`algorithm`\tTEXT,\t`graph_type`\tTEXT,\t`graph_num_nodes`\tINTEGER,\t`graph_num_edges`\tINTEGER,\t`optimistic`\tINTEGER,\t`enable_analysis`\tINTEGER,\t`verbose`\tINTEGER,\t`debug`\tINTEGER,\t`hostname`\tTEXT,\t`error_code`\tINTEGER,\t`graph_depth`\tINTEGER,\t`graph_density`\tINTEGER);";
+
+// PRE:     stmt is a prepared statement
+// POST:    stmt is executed and finalized, returns false on error
+static bool sqliteStep(sqlite3* db, sqlite3_stmt* stmt){
+    bool ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    if(!ok)
+        std::cerr << "SQLite error: " << sqlite3_errmsg(db) << std::endl;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool analysis::sqliteAnalysis(std::string dbFile, std::string comment){
+    sqlite3* db = nullptr;
+    if(sqlite3_open(dbFile.c_str(), &db) != SQLITE_OK){
+        std::cerr << "Could not open database " << dbFile << ": " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_busy_timeout(db, 10000); // several benchmark processes may share one database
+
+    char* errmsg = nullptr;
+    if(sqlite3_exec(db, sqliteSchema, nullptr, nullptr, &errmsg) != SQLITE_OK
+       || sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &errmsg) != SQLITE_OK){
+        std::cerr << "SQLite error: " << errmsg << std::endl;
+        sqlite3_free(errmsg);
+        sqlite3_close(db);
+        return false;
+    }
+
+    #ifdef OPTIMISTIC
+    int opt = OPTIMISTIC;
+    #else
+    int opt = 0;
+    #endif
+
+    double density = (nNodes_ > 1) ? static_cast<double>(nEdges_) / (0.5 * nNodes_ * (nNodes_-1.)) : 0.;
+
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+        "INSERT INTO measurements (date, number_of_threads, processors, comment, total_time, algorithm, graph_type,"
+        " graph_num_nodes, graph_num_edges, optimistic, enable_analysis, verbose, debug, hostname, error_code, graph_depth, graph_density)"
+        " VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?);", -1, &stmt, nullptr);
+    sqlite3_bind_int64(stmt, 1, std::time(nullptr));
+    sqlite3_bind_int(stmt, 2, nThreads_);
+    sqlite3_bind_int(stmt, 3, nProcs_);
+    sqlite3_bind_text(stmt, 4, comment.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 5, time_Total_);
+    sqlite3_bind_text(stmt, 6, algorithmName_.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 7, graphName_.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 8, nNodes_);
+    sqlite3_bind_int64(stmt, 9, nEdges_);
+    sqlite3_bind_int(stmt, 10, opt > 0 ? 1 : 0);
+    sqlite3_bind_int(stmt, 11, ENABLE_ANALYSIS);
+    sqlite3_bind_int(stmt, 12, VERBOSE);
+    sqlite3_bind_int(stmt, 13, DEBUG);
+    sqlite3_bind_text(stmt, 14, getHostname().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 15, errorCode_);
+    sqlite3_bind_int64(stmt, 16, depth_);
+    sqlite3_bind_double(stmt, 17, density);
+    bool ok = sqliteStep(db, stmt);
+    sqlite3_int64 measurementId = sqlite3_last_insert_rowid(db);
+
+    for(const auto& par : parameters_){
+        if(!ok) break;
+        sqlite3_prepare_v2(db, "INSERT INTO parameters (measurement_id, name, value) VALUES (?,?,?);", -1, &stmt, nullptr);
+        sqlite3_bind_int64(stmt, 1, measurementId);
+        sqlite3_bind_text(stmt, 2, par.first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_double(stmt, 3, par.second);
+        ok = sqliteStep(db, stmt);
+    }
+
+    // data structures, then the resident set and the totals per node and edge
+    const type_size structures = structureBytes(memory_);
+    type_parametermap rows(memory_.begin(), memory_.end());
+    rows.push_back(std::make_pair("rssBefore", rssBefore_));
+    rows.push_back(std::make_pair("peakRSS", peakRSS_));
+    rows.push_back(std::make_pair("structureBytes", structures));
+    rows.push_back(std::make_pair("bytesPerNode", nNodes_ > 0 ? static_cast<double>(structures) / nNodes_ : 0.));
+    rows.push_back(std::make_pair("bytesPerEdge", nEdges_ > 0 ? static_cast<double>(structures) / nEdges_ : 0.));
+    rows.push_back(std::make_pair("peakRSSPerNode", nNodes_ > 0 ? static_cast<double>(peakRSS_) / nNodes_ : 0.));
+    rows.push_back(std::make_pair("peakRSSPerEdge", nEdges_ > 0 ? static_cast<double>(peakRSS_) / nEdges_ : 0.));
+    for(const auto& row : rows){
+        if(!ok) break;
+        sqlite3_prepare_v2(db, "INSERT INTO memory (measurement_id, name, bytes) VALUES (?,?,?);", -1, &stmt, nullptr);
+        sqlite3_bind_int64(stmt, 1, measurementId);
+        sqlite3_bind_text(stmt, 2, row.first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_double(stmt, 3, row.second);
+        ok = sqliteStep(db, stmt);
+    }
+
+    #if ENABLE_ANALYSIS == 1
+    // in-depth analysis: one row per thread, timings refer to the row id of their thread
+    const char* timingNames[N_TIMECAT] = {"barrier", "criticalPushBack", "criticalRequestValueUpdate", "currentGather", "currentScatter"};
+    for(type_threadcount i = 0; ok && i < nThreads_; ++i){
+        sqlite3_prepare_v2(db, "INSERT INTO threads (measurement_id, thread_id, processed_nodes, processed_edges) VALUES (?,?,?,?);", -1, &stmt, nullptr);
+        sqlite3_bind_int64(stmt, 1, measurementId);
+        sqlite3_bind_int(stmt, 2, i);
+        sqlite3_bind_int64(stmt, 3, count_ProcessedNodes_[i]);
+        sqlite3_bind_int64(stmt, 4, count_ProcessedEdges_[i]);
+        ok = sqliteStep(db, stmt);
+        sqlite3_int64 threadRowId = sqlite3_last_insert_rowid(db);
+
+        for(int c = 0; ok && c < N_TIMECAT; ++c){
+            sqlite3_prepare_v2(db, "INSERT INTO timings (thread_id, name, value) VALUES (?,?,?);", -1, &stmt, nullptr);
+            sqlite3_bind_int64(stmt, 1, threadRowId);
+            sqlite3_bind_text(stmt, 2, timingNames[c], -1, SQLITE_STATIC);
+            sqlite3_bind_double(stmt, 3, timings_[c][i]);
+            ok = sqliteStep(db, stmt);
+        }
+    }
+    #endif
+
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    return ok;
+}
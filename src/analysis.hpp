@@ -2,40 +2,102 @@
 #define ANALYSIS_HPP
 
 #include "rdtsc_timer.hpp"
+#include "trace.hpp"
 #include <omp.h>
 #include <cassert>
+#include <string>
+#include <utility>
 #include <vector>
 
 #if ENABLE_ANALYSIS == 1
 
 #include <map>
+#include <memory>
 #include <ostream>
+#include <iostream>
+
+#include "aligned_allocator.hpp"
+
+#ifndef ANALYSIS_SAMPLESHIFT
+#define ANALYSIS_SAMPLESHIFT 6
+#endif
+
+#if ENABLE_PERFCOUNTERS == 1
+#include "perf_counters.hpp"
+#endif // ENABLE_PERFCOUNTERS == 1
 
 
 struct analysis {
 
 	// TYPES AND VARIABLES
+	// REQUESTVALUEUPDATE times the whole child loop of a parent, not every edge:
+	// two time stamps per edge cost more than the update they would measure
 	enum timecat {BARRIER,SOLUTIONPUSHBACK,REQUESTVALUEUPDATE,CURRENTGATHER,CURRENTSCATTER,N_TIMECAT};
 	using type_time = double;
-	using type_size = unsigned;
+	using type_size = unsigned long long; // node and edge counts, graphs may exceed 2^32 edges
+	using type_iosize = unsigned long long;
 	using type_threadcount = short;
 	using type_countmap = std::vector<type_size>;
 	using type_timingmap = std::vector<type_time>;
 	using type_timingvector = std::vector<type_timingmap>;
 	using type_clock = util::rdtsc_timer;
-	using type_clockvector = std::vector<type_clock>;
+	using type_ticks = unsigned long long;
     using type_error = int;
+    using type_parametermap = std::vector<std::pair<std::string,double> >;
+    using type_memorymap = std::vector<std::pair<std::string,type_size> >;
+#if ENABLE_PERFCOUNTERS == 1
+	using type_perfvalues = util::perf_values;
+#endif // ENABLE_PERFCOUNTERS == 1
+
+	// Everything a thread writes while sorting. Each block starts on its own
+	// cache line, so threads never share a line with another thread's counters.
+	// Timers read the time stamp counter without serialization, ticks are
+	// converted to seconds once in reduce().
+	struct alignas(util::cacheline) threadblock {
+		threadblock()
+			:	processedNodes_(0)
+			,	processedEdges_(0)
+			,	prefetches_(0)
+		{
+			for(int c=0; c<N_TIMECAT; ++c) {
+				calls_[c] = 0;
+				start_[c] = 0;
+				ticks_[c] = 0;
+			}
+		}
+		type_size processedNodes_;
+		type_size processedEdges_;
+		type_size prefetches_;			// software prefetches issued (prefetch.hpp)
+		type_ticks calls_[N_TIMECAT];	// number of starttiming calls per time category
+		type_ticks start_[N_TIMECAT];	// 0 if the current call is not sampled
+		type_ticks ticks_[N_TIMECAT];	// accumulated ticks of the sampled calls
+#if ENABLE_PERFCOUNTERS == 1
+		std::unique_ptr<util::perf_counters> perf_;	// counters of this thread, opened by the thread itself
+		type_perfvalues perfStart_[N_TIMECAT];		// reading at starttiming(c)
+		type_perfvalues perfPhases_[N_TIMECAT];		// counts accumulated per time category
+		type_perfvalues perfThreadStart_;			// reading at startthreadcounters(tid)
+		type_perfvalues perfThread_;				// counts accumulated between startthreadcounters and stopthreadcounters
+#endif // ENABLE_PERFCOUNTERS == 1
+	};
+	using type_threadblocks = std::vector<threadblock, util::aligned_allocator<threadblock> >;
 
 	analysis()
 		:	count_InitialNodes_(type_countmap()) // still necessary? 
-		,	count_ProcessedNodes_(type_countmap()) // set in function
-		,	count_ProcessedEdges_(type_countmap()) // set in function
+		,	count_ProcessedNodes_(type_countmap()) // set in reduce
+		,	count_ProcessedEdges_(type_countmap()) // set in reduce
+		,	count_Prefetches_(type_countmap()) // set in reduce
 		,	count_LastSyncVal_(type_countmap()) // still necessary?
 		,	time_Total_(0)
+		,	time_IORead_(0)
+		,	time_IOWrite_(0)
+		,	ioBytesRead_(0)
+		,	ioBytesWritten_(0)
+		,	timings_() // set in reduce
+		,	rssBefore_(0)
+		,	peakRSS_(0)
 		,	nThreads_(0) // set in function
 		,	nProcs_(0) // set in function
-		,	clocks_(N_TIMECAT)
-		,	timings_() // set in function
+		,	threadblocks_()
 	{
 
 		nThreads_ = omp_get_max_threads();
@@ -48,18 +110,26 @@ struct analysis {
 		// TODO: Probably count_InitialNodes_ and count_LastSyncVal_ can be removed
 		count_ProcessedNodes_ = type_countmap(nThreads_);
 		count_ProcessedEdges_ = type_countmap(nThreads_);
+		count_Prefetches_ = type_countmap(nThreads_);
 		timings_ = type_timingvector(N_TIMECAT,type_timingmap(nThreads_));
+		threadblocks_ = type_threadblocks(nThreads_);
+		tracer_.init(nThreads_);
 	}
 	
 
 	type_countmap count_InitialNodes_;		// counts how many nodes each thread has initially
 	type_countmap count_ProcessedNodes_;	// counts how many nodes each thread has processed in total
 	type_countmap count_ProcessedEdges_;	// counts how many nodes each thread has processed in total
+	type_countmap count_Prefetches_;		// software prefetches each thread has issued
 	type_countmap count_LastSyncVal_;		// keeps track of the last sync value of each thread
 	type_time time_Total_;
-	type_clockvector clocks_;
+	type_time time_IORead_;				// time spent reading from disk (out-of-core engines)
+	type_time time_IOWrite_;			// time spent writing to disk (out-of-core engines)
+	type_iosize ioBytesRead_;
+	type_iosize ioBytesWritten_;
 	type_clock totalclock_;
-	type_timingvector timings_;
+	type_timingvector timings_;			// [c][tid] seconds, extrapolated from the samples
+	tracer tracer_;						// timeline of per-thread events (only with ENABLE_TRACE)
     
     type_threadcount nThreads_;
     type_threadcount nProcs_;
@@ -71,6 +141,36 @@ struct analysis {
     std::vector<type_size> frontSizes_;
     std::string graphName_;
     type_error errorCode_;
+    type_parametermap parameters_;		// engine specific settings and counters, see setParameter
+    type_memorymap memory_;				// bytes per data structure, see recordMemory
+    type_size rssBefore_;				// resident set size when the sort started
+    type_size peakRSS_;					// peak resident set size during the sort (since the process started if it cannot be reset)
+
+	type_threadblocks threadblocks_;	// thread private counters, reduced into the members above
+
+	// Only every 2^ANALYSIS_SAMPLESHIFT-th call of each time category is timed,
+	// the sum is scaled up accordingly. 0 times every call.
+	static const type_ticks samplemask_ = (type_ticks(1) << ANALYSIS_SAMPLESHIFT) - 1;
+
+	static inline type_ticks ticks() {
+		unsigned lo, hi;
+		asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+		return (type_ticks(hi) << 32) | lo;
+	}
+
+#if ENABLE_PERFCOUNTERS == 1
+	// PRE:		called by thread tid
+	// POST:	v holds the current counter values of thread tid
+	inline void readperf(type_threadcount tid, type_perfvalues& v) {
+		threadblock& tb = threadblocks_[tid];
+		if(!tb.perf_) { // first use by this thread
+			tb.perf_.reset(new util::perf_counters);
+			if(!tb.perf_->open() && tid==0)
+				std::cerr << "\nWARNING:\tperf_event_open failed, hardware counters will be zero (check perf_event_paranoid)\n";
+		}
+		tb.perf_->read(v);
+	}
+#endif // ENABLE_PERFCOUNTERS == 1
     
 	// FUNCTIONS
 	
@@ -82,27 +182,44 @@ struct analysis {
 	
 	inline void processednodes(type_threadcount tid, type_size nNodes) {
 		assert(tid>=0 && tid<nThreads_);
-		count_ProcessedNodes_[tid] = nNodes;
+		threadblocks_[tid].processedNodes_ = nNodes;
 	}
 	
-	inline void incrementProcessedNodes(type_threadcount tid) { // TODO: check if this can be used instead of processednodes (performance??)
+	inline void incrementProcessedNodes(type_threadcount tid) {
 		assert(tid>=0 && tid<nThreads_);
-		++count_ProcessedNodes_[tid];
+		++threadblocks_[tid].processedNodes_;
 	}
 	
-    inline void incrementProcessedEdges(type_threadcount tid, type_size nEdges) { // TODO: check if this can be used instead of processednodes (performance??)
+    inline void incrementProcessedEdges(type_threadcount tid, type_size nEdges) {
 		assert(tid>=0 && tid<nThreads_);
-		count_ProcessedEdges_[tid] += nEdges;
+		threadblocks_[tid].processedEdges_ += nEdges;
+	}
+
+	inline void incrementPrefetches(type_threadcount tid, type_size n) {
+		assert(tid>=0 && tid<nThreads_);
+		threadblocks_[tid].prefetches_ += n;
 	}
 
     inline void frontSizeHistogram(type_size frontSize) {
         frontSizes_.push_back(frontSize);
     }
 
+	inline void setParameter(const std::string& name, double value);
+	inline void recordMemory(const std::string& name, type_size bytes);
+
 	inline void starttotaltiming();
 	
-	inline void starttiming(timecat c) {
-		clocks_[c].start();
+	inline void starttiming(type_threadcount tid, timecat c) {
+		assert(tid>=0 && tid<nThreads_);
+		threadblock& tb = threadblocks_[tid];
+		if((tb.calls_[c]++ & samplemask_) != 0) {
+			tb.start_[c] = 0;
+			return;
+		}
+#if ENABLE_PERFCOUNTERS == 1
+		readperf(tid,tb.perfStart_[c]);
+#endif // ENABLE_PERFCOUNTERS == 1
+		tb.start_[c] = ticks();
 	}
 	
 
@@ -112,13 +229,44 @@ struct analysis {
 		// c stands for the index of the time category we are measuring
 		// tid is the thread id
 		assert(tid>=0 && tid<nThreads_);
-		clocks_[c].stop(); // stop timing
-		timings_[c][tid] += clocks_[c].sec(); // get time in seconds and add to total (for given thread)
+		threadblock& tb = threadblocks_[tid];
+		if(tb.start_[c] == 0) return; // call not sampled
+		tb.ticks_[c] += ticks() - tb.start_[c];
+#if ENABLE_PERFCOUNTERS == 1
+		type_perfvalues now;
+		readperf(tid,now);
+		tb.perfPhases_[c] += now - tb.perfStart_[c];
+#endif // ENABLE_PERFCOUNTERS == 1
+	}
+
+	// Hardware counters of everything a thread does during the sort.
+	// Engines call these at the beginning and end of their parallel regions.
+	inline void startthreadcounters(type_threadcount tid) {
+		assert(tid>=0 && tid<nThreads_);
+#if ENABLE_PERFCOUNTERS == 1
+		readperf(tid,threadblocks_[tid].perfThreadStart_);
+#endif // ENABLE_PERFCOUNTERS == 1
+	}
+
+	inline void stopthreadcounters(type_threadcount tid) {
+		assert(tid>=0 && tid<nThreads_);
+#if ENABLE_PERFCOUNTERS == 1
+		type_perfvalues now;
+		readperf(tid,now);
+		threadblocks_[tid].perfThread_ += now - threadblocks_[tid].perfThreadStart_;
+#endif // ENABLE_PERFCOUNTERS == 1
 	}
 
+	// PRE:		no thread is sorting
+	// POST:	count_* and timings_ hold the totals of the thread blocks
+	void reduce();
+
     bool xmlAnalysis(std::string relativeDir);
+    bool sqliteAnalysis(std::string dbFile, std::string comment);
 private:
     std::string suggestBaseFilename();
+    void startmemory();
+    void stopmemory();
 
 };
 
@@ -128,13 +276,21 @@ struct analysis {
 
 	enum timecat {BARRIER,SOLUTIONPUSHBACK,REQUESTVALUEUPDATE,CURRENTGATHER,CURRENTSCATTER,N_TIMECAT};
 	using type_time = double;
-	using type_size = unsigned;
+	using type_size = unsigned long long; // node and edge counts, graphs may exceed 2^32 edges
+	using type_iosize = unsigned long long;
 	using type_clock = util::rdtsc_timer;
 	using type_threadcount = short;
     using type_error = int;
+    using type_parametermap = std::vector<std::pair<std::string,double> >;
+    using type_memorymap = std::vector<std::pair<std::string,type_size> >;
 
 	type_time time_Total_;
+	type_time time_IORead_;
+	type_time time_IOWrite_;
+	type_iosize ioBytesRead_;
+	type_iosize ioBytesWritten_;
 	type_clock totalclock_;
+	tracer tracer_;
 
     type_threadcount nThreads_;
     type_threadcount nProcs_;
@@ -146,16 +302,27 @@ struct analysis {
     type_error errorCode_;
     std::vector<type_size> nChildrenQuantiles_;
     std::vector<type_size> frontSizes_;
+    type_parametermap parameters_;
+    type_memorymap memory_;
+    type_size rssBefore_;
+    type_size peakRSS_;
 
 	analysis()
 		:	time_Total_(0)
+		,	time_IORead_(0)
+		,	time_IOWrite_(0)
+		,	ioBytesRead_(0)
+		,	ioBytesWritten_(0)
 		,	nThreads_(0) // set in function
 		,	nProcs_(0) // set in function
+		,	rssBefore_(0)
+		,	peakRSS_(0)
 	{
 
 		nThreads_ = omp_get_max_threads();
 		nProcs_ = omp_get_num_procs();
 		assert(nThreads_>0 && nProcs_>0);
+		tracer_.init(nThreads_);
 
 		// std::cout << "\nNT:" << nThreads_ << std::flush;
 		// std::cout << "\nNP:" << nProcs_ << std::flush;
@@ -166,27 +333,63 @@ struct analysis {
 	inline void processednodes(type_threadcount tid, type_size nNodes) {}
 	inline void incrementProcessedNodes(type_threadcount tid) {} // TODO: check if this can be used instead of processednodes (performance??)
     inline void incrementProcessedEdges(type_threadcount tid, type_size nEdges){}
+    inline void incrementPrefetches(type_threadcount tid, type_size n) {}
     inline void frontSizeHistogram(type_size frontSize) {}
+	inline void setParameter(const std::string& name, double value);
+	inline void recordMemory(const std::string& name, type_size bytes);
 	inline void starttotaltiming();
-	inline void starttiming(timecat c) {}
+	inline void starttiming(type_threadcount tid, timecat c) {}
 	inline void stoptotaltiming();
 	inline void stoptiming(type_threadcount tid, timecat c) {}
+	inline void reduce() {}
+	inline void startthreadcounters(type_threadcount tid) {}
+	inline void stopthreadcounters(type_threadcount tid) {}
 	inline void threadcount(type_threadcount n) {}
     bool xmlAnalysis(std::string relativeDir);
+    bool sqliteAnalysis(std::string dbFile, std::string comment);
 private:
     std::string suggestBaseFilename();
+    void startmemory();
+    void stopmemory();
 };
 
 #endif // ENABLE_ANALYSIS==0
 
 
+// Engine settings (thresholds, chunk sizes, ...), engine specific counters and
+// memory are reported with every build, also without ENABLE_ANALYSIS
+inline void analysis::setParameter(const std::string& name, double value) {
+	for(auto& par : parameters_) {
+		if(par.first == name) {
+			par.second = value;
+			return;
+		}
+	}
+	parameters_.push_back(std::make_pair(name,value));
+}
+
+// Bytes held by a data structure of the graph or the engine, reported with every
+// build. A second call with the same name replaces the value.
+inline void analysis::recordMemory(const std::string& name, type_size bytes) {
+	for(auto& mem : memory_) {
+		if(mem.first == name) {
+			mem.second = bytes;
+			return;
+		}
+	}
+	memory_.push_back(std::make_pair(name,bytes));
+}
+
 inline void analysis::starttotaltiming() {
+	startmemory();
 	totalclock_.start();
 }
 
 inline void analysis::stoptotaltiming() {
 	totalclock_.stop();
 	time_Total_ = totalclock_.sec();
+	stopmemory();
+	reduce();
 }
 
 
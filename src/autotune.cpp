@@ -0,0 +1,127 @@
+#include "autotune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+namespace autotune {
+
+	// POST:	returns floor(log2(x)) for x >= 1, 0 otherwise
+	static int ilog2(double x) {
+		return x >= 1. ? static_cast<int>(std::log2(x)) : 0;
+	}
+
+	static bool available(const std::vector<std::string>& engines, const std::string& engine) {
+		return std::find(engines.begin(), engines.end(), engine) != engines.end();
+	}
+
+	std::string profileKey(const Graph::profile& prof) {
+		double meanDegree = prof.nNodes_ > 0 ? static_cast<double>(prof.nEdges_) / prof.nNodes_ : 0.;
+		std::stringstream ss;
+		ss << "n" << ilog2(prof.nNodes_) << "_d" << ilog2(1. + meanDegree) << "_w" << ilog2(prof.widthEstimate_);
+		return ss.str();
+	}
+
+	choice heuristic(const Graph::profile& prof, int maxThreads, const std::vector<std::string>& engines) {
+		choice res;
+		const double meanDegree = prof.nNodes_ > 0 ? static_cast<double>(prof.nEdges_) / prof.nNodes_ : 0.;
+		const Graph::type_size medianChildren = prof.childrenQuantiles_.size() == 5 ? prof.childrenQuantiles_[2] : 0;
+		const Graph::type_size maxChildren = prof.childrenQuantiles_.size() == 5 ? prof.childrenQuantiles_[4] : 0;
+
+		// A thread needs a few thousand nodes per level to pay for the synchronization
+		res.nThreads_ = std::max(1, std::min(maxThreads, static_cast<int>(prof.widthEstimate_ / 2048)));
+
+		if(maxThreads > 1 && prof.widthEstimate_ < 4. && prof.depthEstimate_ > 65536) {
+			res.engine_ = "csr_chains"; // mostly chains, only the branching levels need a barrier
+			res.nThreads_ = maxThreads;
+		}
+		else if(res.nThreads_ == 1 && maxThreads > 1 && prof.widthEstimate_ > 256 && prof.depthEstimate_ > 1024) {
+			res.engine_ = "omp_hybrid"; // long and mostly narrow, only the wide levels get a team
+			res.nThreads_ = maxThreads;
+		}
+		else if(res.nThreads_ == 1)
+			res.engine_ = "serial";
+		else if(maxChildren > 32 * std::max<Graph::type_size>(1, medianChildren))
+			res.engine_ = "omp_worksteal"; // hubs unbalance the static distribution of a level
+		else if(meanDegree >= 8.)
+			res.engine_ = "omp_bitset";
+		else if(prof.depthEstimate_ <= 32)
+			res.engine_ = "omp_dynamic_nobarrier"; // few levels, no need for level barriers
+		else
+			res.engine_ = "omp_locallist";
+
+		if(!available(engines, res.engine_)) {
+			if(res.nThreads_ > 1 && available(engines, "omp_locallist"))
+				res.engine_ = "omp_locallist";
+			else if(available(engines, "serial"))
+				res.engine_ = "serial";
+			else if(!engines.empty())
+				res.engine_ = engines.front();
+		}
+
+		// Chunks of the dynamic schedules: about 8 per thread and level, power of two
+		if(res.engine_ == "omp_bitset" || res.engine_ == "omp_dynamic_nobarrier") {
+			double target = prof.widthEstimate_ / (8. * res.nThreads_);
+			res.chunk_ = 1 << std::min(12, std::max(6, ilog2(target)));
+		}
+		return res;
+	}
+
+	bool lookup(const std::string& tuningFile, const std::string& key, int maxThreads, const std::vector<std::string>& engines, bool explore, choice& res) {
+		std::ifstream f(tuningFile);
+		if(!f) return false;
+
+		// (engine, threads, chunk) -> (sum of seconds, runs)
+		using type_config = std::tuple<std::string,int,int>;
+		std::map<type_config, std::pair<double,int> > runs;
+		std::string line;
+		while(std::getline(f,line)) {
+			std::stringstream ss(line);
+			std::string k, engine;
+			int nThreads, chunk;
+			double seconds;
+			if(!(ss >> k >> engine >> nThreads >> chunk >> seconds)) continue;
+			if(k != key || nThreads > maxThreads || !available(engines, engine)) continue;
+			auto& r = runs[std::make_tuple(engine,nThreads,chunk)];
+			r.first += seconds;
+			++r.second;
+		}
+
+		if(explore) {
+			for(const auto& engine : engines) {
+				bool measured = false;
+				for(const auto& r : runs) measured = measured || std::get<0>(r.first) == engine;
+				if(!measured) {
+					res.engine_ = engine;
+					if(engine == "serial") { res.nThreads_ = 1; res.chunk_ = 0; }
+					else if(res.nThreads_ == 1) res.nThreads_ = maxThreads;
+					return true;
+				}
+			}
+		}
+
+		if(runs.empty()) return false;
+		auto best = std::min_element(runs.begin(), runs.end(), [](const decltype(*runs.begin())& a, const decltype(*runs.begin())& b) {
+			return a.second.first / a.second.second < b.second.first / b.second.second;
+		});
+		res.engine_ = std::get<0>(best->first);
+		res.nThreads_ = std::get<1>(best->first);
+		res.chunk_ = std::get<2>(best->first);
+		return true;
+	}
+
+	bool record(const std::string& tuningFile, const std::string& key, const choice& c, double seconds) {
+		std::ofstream f(tuningFile, std::ios::app);
+		if(!f) {
+			std::cerr << "Could not open file " << tuningFile << std::endl;
+			return false;
+		}
+		f << key << " " << c.engine_ << " " << c.nThreads_ << " " << c.chunk_ << " " << seconds << "\n";
+		return true;
+	}
+
+} // end namespace autotune
@@ -0,0 +1,50 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+
+// Engine selection for the auto mode (toposort_auto.exe).
+//
+// A graph profile is reduced to a coarse key (log2 buckets of size, mean
+// degree and width). The tuning file holds one line per finished run:
+//     <key> <engine> <threads> <chunk> <seconds>
+// For a key with measurements the fastest configuration is chosen, otherwise
+// a rule of thumb derived from the measurement plots decides.
+namespace autotune {
+
+	struct choice {
+		choice()
+			: engine_("omp_locallist")
+			, nThreads_(1)
+			, chunk_(0)
+		{}
+
+		std::string engine_;	// executable is toposort_<engine_>.exe
+		int nThreads_;
+		int chunk_;				// 0: engine default
+	};
+
+	// PRE:		prof from Graph::getProfile()
+	// POST:	returns the tuning file key of the profile
+	std::string profileKey(const Graph::profile& prof);
+
+	// PRE:		engines lists the engines that can be run, maxThreads > 0
+	// POST:	returns the rule of thumb choice for the profile
+	choice heuristic(const Graph::profile& prof, int maxThreads, const std::vector<std::string>& engines);
+
+	// Chooses the fastest recorded configuration for the profile key that
+	// fits into maxThreads. With explore set, an engine of engines without
+	// any record for the key is tried first, with the threads and chunk of res.
+	// PRE:		res holds the heuristic choice
+	// POST:	returns false if nothing was recorded or explored (res is untouched)
+	bool lookup(const std::string& tuningFile, const std::string& key, int maxThreads, const std::vector<std::string>& engines, bool explore, choice& res);
+
+	// POST:	one line for the finished run is appended to the tuning file
+	bool record(const std::string& tuningFile, const std::string& key, const choice& c, double seconds);
+
+} // end namespace autotune
+
+#endif // AUTOTUNE_HPP
@@ -0,0 +1,113 @@
+#ifndef BACKEND_HPP
+#define BACKEND_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <omp.h>
+
+#if ENABLE_THREADPOOL == 1
+#include <functional>
+#include "thread_pool.hpp"
+#endif // ENABLE_THREADPOOL == 1
+
+// Parallel backend of the engines that are written against it (bitset,
+// dynamic_nobarrier). By default the team is an OpenMP parallel region, with
+// POOL=1 (-DENABLE_THREADPOOL=1) it is the persistent util::thread_pool, so
+// a sort does not pay for the fork/join of an OpenMP team. The team asks for
+// omp_get_max_threads() threads in both cases, so OMP_NUM_THREADS still
+// applies. An OpenMP team may get fewer (OMP_DYNAMIC, OMP_THREAD_LIMIT): the
+// engines size their per-thread state by nThreads() and work with the team
+// size run() passes on.
+namespace backend {
+
+	// reported as engine parameter "threadPool"
+	static const bool threadPool = (ENABLE_THREADPOOL == 1);
+
+	// POST:	returns the largest team run() starts
+	inline int nThreads() {
+		return omp_get_max_threads();
+	}
+
+#if ENABLE_THREADPOOL == 1
+
+	// POST:	the pool has nThreads() threads, it is started again if the size changed
+	inline util::thread_pool& pool() {
+		return util::thread_pool::instance(nThreads());
+	}
+
+	// POST:	f(threadID, team) has returned on every thread of the team
+	template <class F>
+	inline void run(F f) {
+		util::thread_pool& team = pool();
+		const int size = team.size();
+		std::function<void(int)> job([&](int threadID) { f(threadID, size); });
+		team.run(job);
+	}
+
+	// PRE:		called by every thread of the team
+	inline void barrier() {
+		util::thread_pool::current().barrier();
+	}
+
+#else
+
+	template <class F>
+	inline void run(F f) {
+		#pragma omp parallel
+		f(omp_get_thread_num(), omp_get_num_threads());
+	}
+
+	inline void barrier() {
+		#pragma omp barrier
+	}
+
+#endif // ENABLE_THREADPOOL == 1
+
+	// PRE:		called by thread threadID of a team of nThreads
+	// POST:	f(i) is called for the threadID-th contiguous slice of [0,n)
+	template <class F>
+	inline void staticFor(int threadID, int nThreads, std::size_t n, F f) {
+		const std::size_t begin = (n * threadID) / nThreads;
+		const std::size_t end = (n * (threadID+1)) / nThreads;
+		for(std::size_t i = begin; i < end; ++i) f(i);
+	}
+
+	// Dynamic schedule with chunks handed out by an atomic counter, the same on
+	// both backends. The loop object is shared by the team.
+	class dynamicLoop {
+
+		public:
+
+			dynamicLoop(std::size_t n, std::size_t chunk)
+				: n_(n)
+				, chunk_(chunk > 0 ? chunk : 1)
+				, next_(0)
+			{}
+
+			// PRE:		no thread is inside forEach
+			inline void reset() {
+				next_.store(0, std::memory_order_relaxed);
+			}
+
+			// POST:	f(i) is called for every i in [0,n) by exactly one of the calling threads
+			template <class F>
+			inline void forEach(F f) {
+				while(true) {
+					const std::size_t begin = next_.fetch_add(chunk_, std::memory_order_relaxed);
+					if(begin >= n_) return;
+					const std::size_t end = std::min(begin + chunk_, n_);
+					for(std::size_t i = begin; i < end; ++i) f(i);
+				}
+			}
+
+		private:
+
+			const std::size_t n_;
+			const std::size_t chunk_;
+			alignas(64) std::atomic<std::size_t> next_;
+	};
+
+} // end namespace backend
+
+#endif // BACKEND_HPP
@@ -0,0 +1,150 @@
+#ifndef BARRIER_HPP
+#define BARRIER_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sched.h>
+#include <omp.h>
+
+#include "aligned_allocator.hpp"
+
+// User-space barrier for the level loops of the list engines, with the sum
+// of one value per thread computed on the way (e.g. the nodes left for the
+// next level), so "is there work left" needs no extra single or barrier.
+//
+// Combining tree of fan-in 4: a thread waits until its children arrived,
+// adds their values to its own and announces its subtree to its parent. The
+// root publishes the sum and releases the team through one cache line that
+// every thread polls. Every thread has a cache line of its own, an arrival
+// moves one line to one waiting parent: about 2*log4(T) line transfers on the
+// critical path instead of T atomic updates of one shared counter. The number
+// of the barrier (epoch) plays the role of the sense of a sense-reversing
+// barrier, nothing is reset between two barriers.
+//
+// Waiting threads spin with exponential backoff and then yield the
+// processor. With more threads than processors they yield at once: the
+// thread they wait for may need the processor.
+namespace spin {
+
+	// POST:	returns true if TOPOSORT_BARRIER=spin selects this barrier over #pragma omp barrier
+	inline bool enabled() {
+		const char* env = std::getenv("TOPOSORT_BARRIER");
+		return env && std::strcmp(env, "spin") == 0;
+	}
+
+	inline void relax() {
+		#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+		#elif defined(__aarch64__)
+		asm volatile("yield");
+		#endif
+	}
+
+	// 1, 2, 4, ... relax() per poll, sched_yield() from yieldAfter on
+	class backoff {
+
+		public:
+
+			static const unsigned defaultYieldAfter = 1024;
+
+			explicit backoff(unsigned yieldAfter = defaultYieldAfter)
+				:	spins_(1)
+				,	yieldAfter_(yieldAfter)
+			{}
+
+			inline void pause() {
+				if(spins_ < yieldAfter_) {
+					for(unsigned i = 0; i < spins_; ++i) relax();
+					spins_ *= 2;
+				} else {
+					sched_yield();
+				}
+			}
+
+		private:
+
+			unsigned spins_;
+			const unsigned yieldAfter_;
+	};
+
+	class barrier {
+
+		public:
+
+			using type_value = long;
+
+			static const int fanIn = 4;
+
+			barrier()
+				:	nThreads_(0)
+				,	yieldAfter_(backoff::defaultYieldAfter)
+			{
+				release_.epoch_ = 0;
+				release_.total_ = 0;
+			}
+
+			// PRE:		no thread is in the barrier
+			// POST:	the barrier is set up for a team of nThreads
+			void reset(int nThreads) {
+				nThreads_ = nThreads;
+				yieldAfter_ = nThreads > omp_get_num_procs() ? 0 : backoff::defaultYieldAfter;
+				slots_.assign(nThreads, slot());
+				release_.epoch_ = 0;
+				release_.total_ = 0;
+			}
+
+			// PRE:		called once by every thread of the team, tid is omp_get_thread_num()
+			// POST:	all threads arrived and see each other's writes before the call,
+			//			returns the sum of value over the team to every thread
+			inline type_value sum(int tid, type_value value) {
+				slot& me = slots_[tid];
+				const unsigned epoch = ++me.epoch_;
+
+				type_value total = value;
+				const int last = fanIn * tid + fanIn < nThreads_ - 1 ? fanIn * tid + fanIn : nThreads_ - 1;
+				for(int c = fanIn * tid + 1; c <= last; ++c) {
+					backoff wait(yieldAfter_);
+					while(__atomic_load_n(&slots_[c].arrived_, __ATOMIC_ACQUIRE) != epoch) wait.pause();
+					total += slots_[c].value_;
+				}
+
+				if(tid == 0) {
+					release_.total_ = total;
+					__atomic_store_n(&release_.epoch_, epoch, __ATOMIC_RELEASE);
+					return total;
+				}
+
+				me.value_ = total;
+				__atomic_store_n(&me.arrived_, epoch, __ATOMIC_RELEASE);
+				backoff wait(yieldAfter_);
+				while(__atomic_load_n(&release_.epoch_, __ATOMIC_ACQUIRE) != epoch) wait.pause();
+				// the root overwrites the total only after this thread arrived at the next barrier
+				return release_.total_;
+			}
+
+			inline void wait(int tid) {
+				sum(tid, 0);
+			}
+
+		private:
+
+			// the arrival of a thread, read by its parent only
+			struct alignas(util::cacheline) slot {
+				unsigned arrived_ = 0;	// epoch of the last arrival
+				unsigned epoch_ = 0;	// barriers passed, private to the thread
+				type_value value_ = 0;	// sum over the subtree
+			};
+
+			int nThreads_;
+			unsigned yieldAfter_;
+			std::vector<slot, util::aligned_allocator<slot>> slots_;
+			struct alignas(util::cacheline) {
+				unsigned epoch_;
+				type_value total_;
+			} release_;
+	};
+
+} // end namespace spin
+
+#endif // BARRIER_HPP
@@ -0,0 +1,127 @@
+#include "blocking.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+
+#include "aligned_allocator.hpp"
+
+namespace blocking {
+
+	// Everything one owner writes, on its own cache lines
+	struct alignas(util::cacheline) worker {
+		std::vector<type_index> frontier;			// owned nodes of the current level
+		std::vector<type_index> next;				// owned nodes of the next level
+		std::vector<std::vector<type_index>> bins;	// [owner] children of other owners to decrement
+		std::size_t local = 0;
+		std::size_t remote = 0;
+	};
+
+	// POST:	v got its slots in the order and its level
+	static void publish(sortState& st, const std::vector<type_index>& nodes, type_index level) {
+		type_index slot = st.reserve(nodes.size());
+		for(type_index v : nodes) {
+			st.put(slot++, v);
+			st.setLevel(v, level);
+		}
+	}
+
+	type_index sort(sortState& st, int nThreads, unsigned blockShift, counters* counts) {
+		const topology& topo = st.getTopology();
+		const type_index N = topo.size();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+		const type_index nBlocks = N > 0 ? ((N - 1) >> blockShift) + 1 : 0;
+		// every owner has at least one block
+		if(static_cast<type_index>(nThreads) > nBlocks) nThreads = std::max<type_index>(nBlocks, 1);
+
+		std::vector<worker, util::aligned_allocator<worker>> workers(nThreads);
+		std::vector<int> ownerOf(nBlocks);	// owner of each block, small enough to stay in cache
+		type_index* indegree = st.indegreeData();
+		type_index nLevels = 0;
+		type_index end = 0;	// order[0,end) is placed
+		bool more = false;
+
+		#pragma omp parallel num_threads(nThreads)
+		{
+			const int tid = omp_get_thread_num();
+			const int team = omp_get_num_threads();
+			worker& w = workers[tid];
+			w.bins.resize(team);
+
+			#pragma omp for schedule(static)
+			for(type_index b = 0; b < nBlocks; ++b) {
+				ownerOf[b] = b % team;
+			}
+
+			// Level 0: the sources among the own blocks
+			for(type_index b = tid; b < nBlocks; b += team) {
+				const type_index last = std::min<std::uint64_t>(N, (std::uint64_t(b) + 1) << blockShift);
+				for(type_index v = b << blockShift; v < last; ++v) {
+					if(indegree[v] == 0) w.frontier.push_back(v);
+				}
+			}
+			publish(st, w.frontier, 0);
+			#pragma omp barrier
+
+			#pragma omp single
+			{
+				end = st.size();
+				nLevels = end > 0 ? 1 : 0;
+				more = end > 0;
+			} // implicit barrier
+
+			while(more) {
+				const type_index childlevel = nLevels;
+
+				// 1. expand the own frontier: own children at once, the others into the bins
+				for(auto& bin : w.bins) bin.clear(); // the owners drained them in the last round
+				for(type_index parent : w.frontier) {
+					for(const type_index* c = topo.childBegin(parent); c != topo.childEnd(parent); ++c) {
+						const int owner = ownerOf[*c >> blockShift];
+						if(owner == tid) {
+							if(--indegree[*c] == 0) w.next.push_back(*c);
+							++w.local;
+						} else {
+							w.bins[owner].push_back(*c);
+							++w.remote;
+						}
+					}
+				}
+				#pragma omp barrier
+
+				// 2. drain the bins addressed to this owner, plain decrements
+				for(int t = 0; t < team; ++t) {
+					for(type_index c : workers[t].bins[tid]) {
+						if(--indegree[c] == 0) w.next.push_back(c);
+					}
+				}
+
+				// 3. the next level, one reservation per owner keeps it contiguous
+				publish(st, w.next, childlevel);
+				w.frontier.swap(w.next);
+				w.next.clear();
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					more = st.size() > end;
+					end = st.size();
+					if(more) ++nLevels;
+				} // implicit barrier
+			}
+		} // end of OMP parallel
+
+		if(counts) {
+			*counts = counters();
+			for(const worker& w : workers) {
+				counts->local_ += w.local;
+				counts->remote_ += w.remote;
+				counts->bytes_ += (w.frontier.capacity() + w.next.capacity()) * sizeof(type_index);
+				for(const auto& bin : w.bins) counts->bytes_ += bin.capacity() * sizeof(type_index);
+			}
+		}
+		return nLevels;
+	}
+
+} // end namespace blocking
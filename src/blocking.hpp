@@ -0,0 +1,40 @@
+#ifndef BLOCKING_HPP
+#define BLOCKING_HPP
+
+#include <cstddef>
+
+#include "topology.hpp"
+#include "sortstate.hpp"
+
+// Owner-computes sort with propagation blocking.
+//
+// The nodes are dealt to the threads in blocks of 2^blockShift consecutive
+// ids, round robin. Only the owner of a node ever touches its in-degree, so
+// a decrement is a plain non-atomic update and a counter never moves between
+// caches. A thread expands the frontier nodes it owns: decrements of its own
+// children are applied at once, the others are appended to a bin per
+// destination thread. After a barrier every owner drains the bins addressed
+// to it. A hub with parents on all threads costs one append per edge instead
+// of one contended atomic per edge.
+namespace blocking {
+
+	using type_index = topology::type_index;
+
+	static const unsigned defaultBlockShift = 10;
+
+	// decrements applied directly by the owner and those that went through a bin
+	struct counters {
+		std::size_t local_ = 0;
+		std::size_t remote_ = 0;
+		std::size_t bytes_ = 0;	// frontiers and bins of all owners at their largest
+	};
+
+	// Level-synchronous sort in its own OpenMP team of nThreads (0: omp_get_max_threads()).
+	// PRE:		st is reset
+	// POST:	st holds a topological order grouped by level and the level of every node,
+	//			returns the depth; counts holds the decrements if not null
+	type_index sort(sortState& st, int nThreads = 0, unsigned blockShift = defaultBlockShift, counters* counts = nullptr);
+
+} // end namespace blocking
+
+#endif // BLOCKING_HPP
@@ -0,0 +1,204 @@
+#include "chains.hpp"
+#include "csrsort.hpp"
+#include "scan.hpp"
+
+#include <algorithm>
+#include <omp.h>
+
+namespace chains {
+
+	contraction::contraction(const topology& topo, int nThreads)
+		: topo_(topo)
+		, super_(topo.size())
+		, rank_(topo.size())
+		, length_()
+		, cyclic_(false)
+		, contracted_()
+	{
+		const type_index N = topo.size();
+		const std::vector<type_index>& indegree = topo.indegrees();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+
+		std::vector<type_index> jump(N);	// chain predecessor, v itself for a head
+		std::vector<type_index> jumpNext(N);
+		std::vector<type_index> rankNext(N);
+		std::vector<type_index> isTail(N);	// 1 for the last node of a chain, then the super-node ids of the tails
+		std::vector<type_index> sums(nThreads + 1);
+		std::vector<topology::type_offset> offsets;
+		std::vector<topology::type_offset> offsetSums(nThreads + 1);
+		std::vector<type_index> targets;
+		type_index nSuper = 0;
+		bool changed = true;
+		const int maxRounds = 8 * sizeof(type_index) + 1; // a ring of links would never end
+
+		#pragma omp parallel num_threads(nThreads)
+		{
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				jump[v] = v;
+				rank_[v] = 0;
+			}
+
+			// link p->c: p has one child and c one parent, no two links share a node
+			#pragma omp for schedule(static)
+			for(type_index p = 0; p < N; ++p) {
+				type_index link = 0;
+				if(topo.childCount(p) == 1) {
+					const type_index c = *topo.childBegin(p);
+					if(indegree[c] == 1) {
+						jump[c] = p;
+						rank_[c] = 1;
+						link = 1;
+					}
+				}
+				isTail[p] = 1 - link;
+			}
+
+			// Pointer jumping: after round k every node points 2^k links towards its head
+			for(int round = 0; changed && round < maxRounds; ++round) {
+				#pragma omp barrier
+				#pragma omp single
+				changed = false;
+
+				bool localChanged = false;
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					const type_index j = jump[v];
+					jumpNext[v] = jump[j];
+					rankNext[v] = rank_[v] + rank_[j]; // a head has rank 0
+					localChanged = localChanged || jump[j] != j;
+				}
+				if(localChanged) changed = true; // benign race, all writers store true
+
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					jump[v] = jumpNext[v];
+					rank_[v] = rankNext[v];
+				}
+			}
+
+			// a ring of links has no head, its nodes still point somewhere else
+			#pragma omp single
+			cyclic_ = changed;
+
+			// number the chains by their tails; heads are found through jump
+			const type_index nTails = scan::exclusive(isTail, sums);
+			#pragma omp single
+			{
+				nSuper = nTails;
+				length_.resize(nSuper);
+				offsets.resize(nSuper + 1);
+			} // implicit barrier
+
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				const bool tail = (v + 1 < N ? isTail[v + 1] : nSuper) != isTail[v];
+				if(tail) {
+					const type_index s = isTail[v];
+					super_[jump[v]] = s;	// head
+					length_[s] = rank_[v] + 1;
+					offsets[s] = topo.childCount(v);
+				}
+			}
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				if(jump[v] != v) super_[v] = super_[jump[v]];
+			}
+
+			// contracted edges: the children of the tails are heads of other chains
+			#pragma omp single
+			offsets[nSuper] = 0;
+			const topology::type_offset nEdges = scan::exclusive(offsets, offsetSums);
+			#pragma omp single
+			targets.resize(nEdges);
+
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				const bool tail = (v + 1 < N ? isTail[v + 1] : nSuper) != isTail[v];
+				if(tail) {
+					topology::type_offset e = offsets[isTail[v]];
+					for(const type_index* c = topo.childBegin(v); c != topo.childEnd(v); ++c) {
+						targets[e++] = super_[*c];
+					}
+				}
+			}
+		} // end of OMP parallel
+
+		contracted_.reset(new topology(std::move(offsets), std::move(targets)));
+	}
+
+	type_index sort(const contraction& con, sortState& st, int nThreads) {
+		const topology& topo = con.original();
+		const topology& ctopo = con.contracted();
+		const type_index N = topo.size();
+		const type_index S = ctopo.size();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+
+		if(con.cyclic()) {
+			return 0; // a ring of links, nothing can be expanded
+		}
+
+		sortState cst(ctopo);
+		const type_index cdepth = csrsort::levels(cst, nThreads);
+		if(cst.size() != S) {
+			return 0; // cycle, the order stays incomplete like in csrsort
+		}
+		const std::vector<type_index>& corder = cst.order();
+		const std::vector<type_index>& clevel = cst.levels();
+
+		std::vector<type_index> position(S);	// first slot of every chain in the order, by order index
+		std::vector<type_index> slot(S);		// the same by super-node
+		std::vector<type_index> start(S, 0);	// level of the head of every chain
+		std::vector<type_index> levelBegin(cdepth + 1);
+		std::vector<type_index> sums(nThreads + 1);
+		type_index* order = st.orderData();
+		type_index depth = 0;
+
+		#pragma omp parallel num_threads(nThreads) reduction(max:depth)
+		{
+			#pragma omp for schedule(static)
+			for(type_index i = 0; i < S; ++i) {
+				position[i] = con.length(corder[i]);
+				if(i == 0 || clevel[corder[i]] != clevel[corder[i - 1]]) levelBegin[clevel[corder[i]]] = i;
+			}
+			#pragma omp single
+			levelBegin[cdepth] = S;
+			scan::exclusive(position, sums);
+
+			#pragma omp for schedule(static) nowait
+			for(type_index i = 0; i < S; ++i) {
+				slot[corder[i]] = position[i];
+			}
+
+			// levels: one push round per contracted level, every parent chain is final before its children
+			for(type_index k = 0; k < cdepth; ++k) {
+				#pragma omp for schedule(dynamic, 256)
+				for(type_index i = levelBegin[k]; i < levelBegin[k + 1]; ++i) {
+					const type_index s = corder[i];
+					const type_index end = start[s] + con.length(s);
+					depth = std::max(depth, end);
+					for(const type_index* c = ctopo.childBegin(s); c != ctopo.childEnd(s); ++c) {
+						type_index old = start[*c];
+						while(old < end) { // atomic max
+							const type_index seen = __sync_val_compare_and_swap(&start[*c], old, end);
+							if(seen == old) break;
+							old = seen;
+						}
+					}
+				} // implicit barrier
+			}
+
+			// expansion: the chains follow the contracted order, the nodes of a chain their rank
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				const type_index s = con.superOf(v);
+				order[slot[s] + con.rank(v)] = v;
+				st.setLevel(v, start[s] + con.rank(v));
+			}
+		} // end of OMP parallel
+
+		st.reserve(N); // publish the size of the order
+		return depth;
+	}
+
+} // end namespace chains
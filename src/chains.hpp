@@ -0,0 +1,87 @@
+#ifndef CHAINS_HPP
+#define CHAINS_HPP
+
+#include <memory>
+#include <vector>
+
+#include "topology.hpp"
+#include "sortstate.hpp"
+
+// Chain compression for deep graphs.
+//
+// An edge p->c is a chain link if p has exactly one child and c exactly one
+// parent. The links split the nodes into maximal chains (most of length 1),
+// every chain is collapsed into a super-node of a contracted topology. Only
+// the contracted topology is sorted level by level, the chains are expanded
+// afterwards. A level-synchronous sort thus needs one round per branching
+// level instead of one per level: a CHAIN graph contracts to a single node.
+namespace chains {
+
+	using type_index = topology::type_index;
+
+	class contraction {
+
+		public:
+
+			// Finds the chains by pointer jumping (log2 of the longest chain rounds)
+			// and builds the contracted topology, in an OpenMP team of nThreads (0: omp_get_max_threads())
+			explicit contraction(const topology& topo, int nThreads = 0);
+
+			inline const topology& original() const {
+				return topo_;
+			}
+
+			// super-nodes and the edges between them: from the last node of a chain to the heads of others
+			inline const topology& contracted() const {
+				return *contracted_;
+			}
+
+			// super-node of node v
+			inline type_index superOf(type_index v) const {
+				return super_[v];
+			}
+
+			// position of v in its chain, 0 for the head
+			inline type_index rank(type_index v) const {
+				return rank_[v];
+			}
+
+			// number of nodes in super-node s
+			inline type_index length(type_index s) const {
+				return length_[s];
+			}
+
+			// true if some links close into a ring without a head (a cycle in which every
+			// node has one parent and one child); superOf, rank and length are then invalid
+			inline bool cyclic() const {
+				return cyclic_;
+			}
+
+			// bytes of the chain tables and the contracted topology
+			inline std::size_t bytes() const {
+				return (super_.capacity() + rank_.capacity() + length_.capacity()) * sizeof(type_index)
+					+ (contracted_ ? contracted_->bytes() : 0);
+			}
+
+		private:
+
+			const topology& topo_;
+			std::vector<type_index> super_;
+			std::vector<type_index> rank_;
+			std::vector<type_index> length_;
+			bool cyclic_;
+			std::unique_ptr<const topology> contracted_;
+	};
+
+	// Sorts the contracted topology with csrsort::levels and expands the chains
+	// in place. The order keeps the nodes of a chain together, so unlike the
+	// csrsort engines it is not grouped by level; the levels are the exact
+	// longest-path levels nonetheless.
+	// PRE:		st is a reset state of con.original()
+	// POST:	st holds a topological order and the level of every node, returns the depth;
+	//			on a cycle returns 0 and st.size() < N, like the csrsort engines
+	type_index sort(const contraction& con, sortState& st, int nThreads = 0);
+
+} // end namespace chains
+
+#endif // CHAINS_HPP
@@ -0,0 +1,209 @@
+#include "components.hpp"
+#include "csrsort.hpp"
+#include "scan.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <omp.h>
+
+namespace components {
+
+	// root of x, halves the path on the way
+	static inline type_index find(std::vector<type_index>& parent, type_index x) {
+		while(parent[x] != x) {
+			const type_index grandparent = parent[parent[x]];
+			parent[x] = grandparent; // benign race, any ancestor is correct
+			x = grandparent;
+		}
+		return x;
+	}
+
+	// links the larger root below the smaller one, so every root is the smallest id of its tree
+	static inline void unite(std::vector<type_index>& parent, type_index u, type_index w) {
+		while(true) {
+			u = find(parent, u);
+			w = find(parent, w);
+			if(u == w) return;
+			if(u > w) std::swap(u, w);
+			if(__sync_bool_compare_and_swap(&parent[w], w, u)) return;
+		}
+	}
+
+	decomposition::decomposition(const topology& topo, int nThreads)
+		: topo_(topo)
+		, component_(topo.size())
+		, begin_()
+		, members_(topo.size())
+		, local_(topo.size())
+	{
+		const type_index N = topo.size();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+
+		std::vector<type_index> parent(N);
+		std::vector<type_index> root(N);	// 1 for a root, then the component ids of the roots
+		std::vector<type_index> cursor;
+		std::vector<type_index> sums(nThreads + 1);
+
+		#pragma omp parallel num_threads(nThreads)
+		{
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				parent[v] = v;
+			}
+
+			#pragma omp for schedule(dynamic, 1024)
+			for(type_index v = 0; v < N; ++v) {
+				for(const type_index* c = topo.childBegin(v); c != topo.childEnd(v); ++c) {
+					unite(parent, v, *c);
+				}
+			}
+
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				parent[v] = find(parent, v);
+			}
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				root[v] = parent[v] == v;
+			}
+
+			// the roots are the smallest ids, numbering them in order numbers the components by it
+			const type_index nComponents = scan::exclusive(root, sums);
+			#pragma omp single
+			begin_.assign(nComponents + 1, 0);
+
+			if(nComponents == 1) {
+				// connected: the members are all nodes in order
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					component_[v] = 0;
+					members_[v] = v;
+					local_[v] = v;
+				}
+				#pragma omp single
+				begin_[1] = N;
+			} else {
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					component_[v] = root[parent[v]];
+					__sync_fetch_and_add(&begin_[component_[v]], 1);
+				}
+				scan::exclusive(begin_, sums);
+
+				#pragma omp single
+				cursor = begin_;
+
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					members_[__sync_fetch_and_add(&cursor[component_[v]], 1)] = v;
+				}
+
+				// the fill order depends on the threads, sorting keeps the local ids reproducible
+				#pragma omp for schedule(dynamic, 64)
+				for(type_index c = 0; c < nComponents; ++c) {
+					std::sort(members_.begin() + begin_[c], members_.begin() + begin_[c+1]);
+					for(type_index i = begin_[c]; i < begin_[c+1]; ++i) {
+						local_[members_[i]] = i - begin_[c];
+					}
+				}
+			}
+		} // end of OMP parallel
+	}
+
+	topology decomposition::subTopology(type_index c) const {
+		const type_index n = size(c);
+		const type_index* member = members_.data() + begin_[c];
+		std::vector<topology::type_offset> offsets(n + 1, 0);
+		for(type_index i = 0; i < n; ++i) {
+			offsets[i+1] = offsets[i] + topo_.childCount(member[i]);
+		}
+		std::vector<type_index> targets;
+		targets.reserve(offsets[n]);
+		for(type_index i = 0; i < n; ++i) {
+			for(const type_index* ch = topo_.childBegin(member[i]); ch != topo_.childEnd(member[i]); ++ch) {
+				targets.push_back(local_[*ch]);
+			}
+		}
+		return topology(std::move(offsets), std::move(targets));
+	}
+
+	// copies the order and the levels of the sort of component c into the global state
+	static void publish(const decomposition& dec, type_index c, const sortState& local, sortState& st) {
+		const type_index first = dec.begin(c);
+		const type_index* member = dec.members().data() + first;
+		type_index* order = st.orderData();
+		const type_index n = local.size();
+		#pragma omp parallel for schedule(static) if(n >= 65536)
+		for(type_index i = 0; i < n; ++i) {
+			const type_index v = local.order()[i];
+			order[first + i] = member[v];
+			st.setLevel(member[v], local.levels()[v]);
+		}
+	}
+
+	type_index sort(const decomposition& dec, sortState& st, type_index parallelThreshold, int nThreads) {
+		const type_index C = dec.count();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+		std::vector<type_index> large;
+		std::vector<type_index> small;
+		std::vector<type_index> singletons;
+		type_index nLarge = 0;
+		for(type_index c = 0; c < C; ++c) {
+			if(dec.size(c) >= parallelThreshold) {
+				large.push_back(c);
+				nLarge += dec.size(c);
+			}
+			else if(dec.size(c) > 1) small.push_back(c);
+			else singletons.push_back(c);
+		}
+		// Mostly one giant component: its levels are paid for anyway, the small
+		// components ride along in the same rounds instead of being copied out
+		if(C == 1 || nLarge >= dec.original().size() / 2) {
+			return csrsort::levels(st, nThreads);
+		}
+		// largest first, the dynamic schedule balances the tail
+		std::stable_sort(small.begin(), small.end(), [&dec](type_index a, type_index b) {
+			return dec.size(a) > dec.size(b);
+		});
+
+		type_index depth = 0;
+		type_index nOrdered = 0;
+
+		for(type_index c : large) {
+			topology sub = dec.subTopology(c);
+			sortState local(sub);
+			depth = std::max(depth, csrsort::levels(local, nThreads));
+			publish(dec, c, local, st);
+			nOrdered += local.size();
+		}
+
+		type_index* order = st.orderData();
+		const type_index nSmall = small.size();
+		const type_index nSingletons = singletons.size();
+		#pragma omp parallel num_threads(nThreads) reduction(max:depth) reduction(+:nOrdered)
+		{
+			#pragma omp for schedule(static) nowait
+			for(type_index i = 0; i < nSingletons; ++i) {
+				const type_index c = singletons[i];
+				order[dec.begin(c)] = dec.members()[dec.begin(c)];
+				st.setLevel(dec.members()[dec.begin(c)], 0);
+				depth = 1;
+				++nOrdered;
+			}
+
+			#pragma omp for schedule(dynamic, 1)
+			for(type_index i = 0; i < nSmall; ++i) {
+				const type_index c = small[i];
+				topology sub = dec.subTopology(c);
+				sortState local(sub);
+				depth = std::max(depth, csrsort::serial(local));
+				publish(dec, c, local, st);
+				nOrdered += local.size();
+			}
+		} // end of OMP parallel
+
+		st.reserve(nOrdered); // publish the size, a cyclic component leaves a gap
+		return depth;
+	}
+
+} // end namespace components
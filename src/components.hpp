@@ -0,0 +1,84 @@
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include <vector>
+
+#include "topology.hpp"
+#include "sortstate.hpp"
+
+// Weakly connected components of a topology.
+//
+// Nodes of different components share no edge, so every component can be
+// sorted on its own without waiting for the levels of the others. The
+// orders of the components are concatenated in the order of their ids.
+namespace components {
+
+	using type_index = topology::type_index;
+
+	class decomposition {
+
+		public:
+
+			// Lock-free union-find over the edges in an OpenMP team of nThreads (0: omp_get_max_threads()).
+			// Component ids follow the smallest node id of the components, the members of a component are sorted.
+			explicit decomposition(const topology& topo, int nThreads = 0);
+
+			inline const topology& original() const {
+				return topo_;
+			}
+
+			inline type_index count() const {
+				return static_cast<type_index>(begin_.size() - 1);
+			}
+
+			inline type_index componentOf(type_index v) const {
+				return component_[v];
+			}
+
+			// the members of component c are members()[begin(c)] ... members()[begin(c+1)-1]
+			inline type_index begin(type_index c) const {
+				return begin_[c];
+			}
+
+			inline type_index size(type_index c) const {
+				return begin_[c+1] - begin_[c];
+			}
+
+			inline const std::vector<type_index>& members() const {
+				return members_;
+			}
+
+			// index of v among the members of its component
+			inline type_index local(type_index v) const {
+				return local_[v];
+			}
+
+			// POST:	returns the CSR topology of component c with the local ids
+			topology subTopology(type_index c) const;
+
+			// bytes of the component tables
+			inline std::size_t bytes() const {
+				return (component_.capacity() + begin_.capacity() + members_.capacity() + local_.capacity()) * sizeof(type_index);
+			}
+
+		private:
+
+			const topology& topo_;
+			std::vector<type_index> component_;
+			std::vector<type_index> begin_;
+			std::vector<type_index> members_;
+			std::vector<type_index> local_;
+	};
+
+	// Sorts every component as an independent job. Components with at least
+	// parallelThreshold nodes are sorted one after the other with csrsort::levels
+	// and the whole team, the others in parallel with csrsort::serial, one per thread.
+	// If the large components hold half of the nodes or more, the whole topology
+	// is sorted with csrsort::levels instead.
+	// PRE:		st is a reset state of dec.original()
+	// POST:	st holds a topological order and the level of every node, returns the depth
+	type_index sort(const decomposition& dec, sortState& st, type_index parallelThreshold, int nThreads = 0);
+
+} // end namespace components
+
+#endif // COMPONENTS_HPP
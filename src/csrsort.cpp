@@ -0,0 +1,169 @@
+#include "csrsort.hpp"
+#include "simd_kernels.hpp"
+#include "prefetch.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <omp.h>
+
+namespace csrsort {
+
+	template <typename State>
+	typename State::type_index serial(State& st) {
+		using type_index = typename State::type_index;
+		const typename State::type_topology& topo = st.getTopology();
+		const type_index N = topo.size();
+		type_index* order = st.orderData();
+		type_index* indegree = st.indegreeData();
+
+		// Sources first, then the order array is the queue
+		type_index tail = kernels::findSources(indegree, 0, N, order);
+		type_index depth = tail > 0 ? 1 : 0;
+		// the queue is the frontier, the pipeline runs dist and 2*dist entries ahead of the head
+		const std::size_t dist = prefetch::distance();
+		for(type_index head = 0; head < tail; ++head) {
+			if(dist > 0) {
+				if(head + 2 * dist < tail) prefetch::childList(topo, order[head + 2 * dist]);
+				if(head + dist < tail) prefetch::counters(topo, order[head + dist], indegree);
+			}
+			const type_index parent = order[head];
+			const type_index childlevel = st.levels()[parent] + 1;
+			// the ready children are appended to the queue directly
+			const type_index nReady = kernels::decrementBatch(indegree, topo.childBegin(parent),
+				topo.childCount(parent), order + tail, N);
+			if(nReady > 0) {
+				for(type_index i = tail; i < tail + nReady; ++i) st.setLevel(order[i], childlevel);
+				depth = std::max(depth, childlevel + 1);
+				tail += nReady;
+			}
+		}
+		st.reserve(tail); // publish the size of the order
+		return depth;
+	}
+
+	// POST:	level is handed to out, streaming is false once out failed
+	template <typename Index>
+	static void emit(sink::basic_levelSink<Index>* out, bool& streaming, Index level, const Index* order, Index begin, Index end) {
+		if(streaming && !out->level(level, order + begin, end - begin)) {
+			std::cerr << "\nERROR:\tcsrsort::levels stopped streaming at level " << level << std::endl;
+			streaming = false;
+		}
+	}
+
+	template <typename State>
+	typename State::type_index levels(State& st, int nThreads, sink::basic_levelSink<typename State::type_index>* out) {
+		using type_index = typename State::type_index;
+		const typename State::type_topology& topo = st.getTopology();
+		const type_index N = topo.size();
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+
+		type_index begin = 0;	// current level is order[begin,end)
+		type_index end = 0;
+		type_index depth = 0;
+
+		// chunks of the level are handed out dynamically, each runs the prefetch pipeline
+		const type_index chunk = 256;
+		const std::size_t dist = prefetch::distance();
+		type_index* indegree = st.indegreeData();
+		bool streaming = out != nullptr;
+		auto far = [&topo](type_index v) { return prefetch::childList(topo, v); };
+		auto near = [&topo, indegree](type_index v) { return prefetch::counters(topo, v, indegree); };
+
+		#pragma omp parallel num_threads(nThreads)
+		{
+			std::vector<type_index> next_local;
+
+			// Level 0: the sources, every thread scans a contiguous slice
+			const type_index tid = omp_get_thread_num();
+			const type_index team = omp_get_num_threads();
+			const type_index first = N / team * tid + std::min(tid, N % team);
+			const type_index last = first + N / team + (tid < N % team ? 1 : 0);
+			next_local.resize(last - first);
+			next_local.resize(kernels::findSources(st.indegreeData(), first, last, next_local.data()));
+			type_index slot = st.reserve(next_local.size());
+			for(auto v : next_local) st.put(slot++, v);
+			next_local.clear();
+			#pragma omp barrier
+
+			#pragma omp single
+			end = st.size();
+
+			// The level is final once placed. One thread hands it over and joins
+			// the expansion of the next level late, the dynamic chunks even that out.
+			if(out) {
+				#pragma omp single nowait
+				emit(out, streaming, type_index(0), st.order().data(), begin, end);
+			}
+
+			while(begin < end) {
+				const type_index childlevel = depth + 1;
+				const type_index nChunks = (end - begin + chunk - 1) / chunk;
+				#pragma omp for schedule(dynamic, 1) nowait
+				for(type_index k = 0; k < nChunks; ++k) {
+					const type_index first = begin + k * chunk;
+					const type_index last = std::min<type_index>(end, first + chunk);
+					prefetch::forEach(st.order().data(), first, last, dist, far, near, [&](type_index parent) {
+						for(const type_index* c = topo.childBegin(parent); c != topo.childEnd(parent); ++c) {
+							if(st.decrement(*c)) {
+								st.setLevel(*c, childlevel);
+								next_local.push_back(*c);
+							}
+						}
+					});
+				}
+				// one reservation per thread and level keeps the level contiguous
+				slot = st.reserve(next_local.size());
+				for(auto v : next_local) st.put(slot++, v);
+				next_local.clear();
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					begin = end;
+					end = st.size();
+					++depth;
+				} // implicit barrier
+
+				if(out && begin < end) {
+					#pragma omp single nowait
+					emit(out, streaming, depth, st.order().data(), begin, end);
+				}
+			}
+		} // end of OMP parallel
+
+		return depth;
+	}
+
+	template <typename Topology>
+	bool isTopological(const Topology& topo, const std::vector<typename Topology::type_index>& order) {
+		using type_index = typename Topology::type_index;
+		const type_index N = topo.size();
+		if(order.size() != N) return false;
+		std::vector<type_index> position(N, N);
+		for(type_index i = 0; i < N; ++i) {
+			if(order[i] >= N || position[order[i]] != N) return false; // not a permutation
+			position[order[i]] = i;
+		}
+		bool correct = true;
+		#pragma omp parallel for reduction(&&:correct)
+		for(type_index v = 0; v < N; ++v) {
+			for(const type_index* c = topo.childBegin(v); c != topo.childEnd(v); ++c) {
+				correct = correct && position[v] < position[*c];
+			}
+		}
+		return correct;
+	}
+
+	template topology::type_index serial(sortState&);
+	template topology32::type_index serial(sortState32&);
+	template topology64::type_index serial(sortState64&);
+
+	template topology::type_index levels(sortState&, int, sink::basic_levelSink<topology::type_index>*);
+	template topology32::type_index levels(sortState32&, int, sink::basic_levelSink<topology32::type_index>*);
+	template topology64::type_index levels(sortState64&, int, sink::basic_levelSink<topology64::type_index>*);
+
+	template bool isTopological(const topology&, const std::vector<topology::type_index>&);
+	template bool isTopological(const topology32&, const std::vector<topology32::type_index>&);
+	template bool isTopological(const topology64&, const std::vector<topology64::type_index>&);
+
+} // end namespace csrsort
@@ -0,0 +1,42 @@
+#ifndef CSRSORT_HPP
+#define CSRSORT_HPP
+
+#include <vector>
+
+#include "topology.hpp"
+#include "sortstate.hpp"
+#include "sink.hpp"
+
+// Sort engines that work on a shared topology and a per-run sortState only.
+// They do not touch the Node objects, so unlike the Graph::topSort() engines
+// they can sort one graph repeatedly and from several threads at the same time.
+// The order is grouped by level: all nodes of level k precede those of level k+1.
+namespace csrsort {
+
+	using type_index = topology::type_index;
+
+	// The engines are templates over the state, instantiated in csrsort.cpp for
+	// sortState, sortState32 and sortState64 (sortstate.hpp).
+
+	// PRE:		st is reset
+	// POST:	st holds a topological order and the level of every node, returns the depth
+	template <typename State>
+	typename State::type_index serial(State& st);
+
+	// Level-synchronous parallel sort in its own OpenMP team of nThreads (0: omp_get_max_threads()).
+	// The order array doubles as the frontier queue: level k is a contiguous
+	// range of it, every thread appends the nodes it finds for level k+1 in one block.
+	// Every completed level goes to out (if not null) while the team expands the next one.
+	// PRE:		st is reset
+	// POST:	as serial
+	template <typename State>
+	typename State::type_index levels(State& st, int nThreads = 0,
+		sink::basic_levelSink<typename State::type_index>* out = nullptr);
+
+	// POST:	returns true if order is a permutation of the nodes of topo that respects every edge
+	template <typename Topology>
+	bool isTopological(const Topology& topo, const std::vector<typename Topology::type_index>& order);
+
+} // end namespace csrsort
+
+#endif // CSRSORT_HPP
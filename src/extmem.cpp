@@ -0,0 +1,418 @@
+#include "extmem.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace extmem {
+
+// PRE:
+// POST:	prints an error and terminates, the engine cannot continue without its files
+static void ioFailure(const std::string& what, const std::string& path) {
+	std::cerr << "\nERROR:\textmem could not " << what << " " << path << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// bufferedWriter
+////////////////////////////////////////////////////////////////////////////////
+
+bufferedWriter::bufferedWriter(iostats& stats, std::size_t bufsize)
+	: stats_(stats)
+	, buf_(std::max(bufsize,sizeof(type_index)))
+	, pos_(0)
+	, count_(0)
+	, path_()
+	, append_(false)
+	, file_(nullptr)
+{}
+
+bufferedWriter::~bufferedWriter() {
+	close();
+}
+
+void bufferedWriter::open(const std::string& path, bool append) {
+	assert(file_==nullptr && path_.empty());
+	path_ = path;
+	append_ = append;
+	pos_ = 0;
+	count_ = 0;
+}
+
+void bufferedWriter::flush() {
+	if(pos_==0) return;
+	assert(!path_.empty());
+	if(file_==nullptr) {
+		file_ = std::fopen(path_.c_str(), append_ ? "ab" : "wb");
+		if(file_==nullptr) ioFailure("open for writing",path_);
+	}
+	analysis::type_clock clock;
+	clock.start();
+	if(std::fwrite(&buf_[0],1,pos_,file_) != pos_) ioFailure("write","output file");
+	clock.stop();
+	stats_.time_Write_ += clock.sec();
+	stats_.bytesWritten_ += pos_;
+	pos_ = 0;
+}
+
+void bufferedWriter::close() {
+	if(path_.empty()) return;
+	flush();
+	if(file_!=nullptr) std::fclose(file_);
+	file_ = nullptr;
+	path_.clear();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// bufferedReader
+////////////////////////////////////////////////////////////////////////////////
+
+// first read after open() or a seek
+static const std::size_t minReadahead = 4096;
+
+bufferedReader::bufferedReader(iostats& stats, std::size_t bufsize)
+	: stats_(stats)
+	, buf_(std::max(bufsize,sizeof(type_index)))
+	, pos_(0)
+	, end_(0)
+	, readahead_(0)
+	, bufstart_(0)
+	, file_(nullptr)
+{}
+
+bufferedReader::~bufferedReader() {
+	close();
+}
+
+bool bufferedReader::open(const std::string& path) {
+	assert(file_==nullptr);
+	file_ = std::fopen(path.c_str(),"rb");
+	pos_ = 0;
+	end_ = 0;
+	readahead_ = minReadahead;
+	bufstart_ = 0;
+	return file_!=nullptr;
+}
+
+void bufferedReader::close() {
+	if(file_==nullptr) return;
+	std::fclose(file_);
+	file_ = nullptr;
+}
+
+// INVARIANT: the file position always equals bufstart_+end_
+bool bufferedReader::refill() {
+	assert(file_!=nullptr);
+	std::size_t rest = end_-pos_;
+	std::memmove(&buf_[0],&buf_[pos_],rest);
+	bufstart_ += pos_;
+	pos_ = 0;
+
+	analysis::type_clock clock;
+	clock.start();
+	std::size_t n = std::fread(&buf_[rest],1,std::min(readahead_,buf_.size()-rest),file_);
+	clock.stop();
+	readahead_ = std::min(2*readahead_,buf_.size());
+	stats_.time_Read_ += clock.sec();
+	stats_.bytesRead_ += n;
+
+	end_ = rest + n;
+	return end_ >= sizeof(type_index);
+}
+
+void bufferedReader::seek(type_offset offset) {
+	assert(offset >= tell());
+	if(offset <= bufstart_+end_) { // target is inside the buffered window
+		pos_ = offset-bufstart_;
+		return;
+	}
+	if(fseeko(file_,offset,SEEK_SET) != 0) ioFailure("seek in","partition file");
+	bufstart_ = offset;
+	pos_ = 0;
+	end_ = 0;
+	readahead_ = minReadahead;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// edgeStore
+////////////////////////////////////////////////////////////////////////////////
+
+// size of the buffer of every open partition or bucket file
+static const std::size_t defaultBufsize = 1 << 18;
+
+edgeStore::edgeStore(type_index N, type_offset nEdgesHint, type_offset memBudget, std::string dir, iostats& stats)
+	: indegree_(N,0)
+	, N_(N)
+	, nEdges_(0)
+	, memBudget_(memBudget)
+	, nPartitions_(1)
+	, partSize_(N)
+	, dir_(dir)
+	, prefix_()
+	, stats_(stats)
+	, rawWriters_()
+	, skip_()
+	, finalized_(false)
+{
+	assert(N_>0);
+	if(dir_.empty()) dir_ = ".";
+	if(dir_.back() != '/') dir_ += "/";
+	// Runs sharing dir (default /tmp) must not clobber each other's files:
+	// pid for concurrent processes, a counter for several stores of one process
+	static unsigned instances = 0;
+	std::stringstream ss;
+	ss << dir_ << "extmem_" << getpid() << "_" << __atomic_fetch_add(&instances, 1, __ATOMIC_RELAXED) << "_";
+	prefix_ = ss.str();
+
+	// Sorting one partition needs its edges (two ids per edge) plus a counter
+	// per source. Whatever the in-degree array leaves of the budget is spent on that.
+	const type_offset indegBytes = type_offset(N_)*sizeof(type_index);
+	const type_offset minWorkspace = type_offset(16) << 20;
+	type_offset workspace = memBudget_ > indegBytes + minWorkspace ? memBudget_ - indegBytes : minWorkspace;
+	type_offset perPartition = nEdgesHint*2*sizeof(type_index) + type_offset(N_)*sizeof(type_offset);
+	nPartitions_ = std::max<type_offset>(1, (perPartition + workspace - 1)/workspace);
+	nPartitions_ = std::min(nPartitions_, N_);
+	partSize_ = 1 + (N_-1)/nPartitions_;
+	nPartitions_ = 1 + (N_-1)/partSize_;
+
+	std::size_t bufsize = std::min<type_offset>(defaultBufsize, std::max<type_offset>(4096, workspace/(4*nPartitions_)));
+	rawWriters_.resize(nPartitions_);
+	for(type_index p=0; p<nPartitions_; ++p) {
+		rawWriters_[p] = new bufferedWriter(stats_,bufsize);
+		rawWriters_[p]->open(rawPath(p));
+	}
+
+	#if VERBOSE>0
+	std::cout << "\nextmem: " << nPartitions_ << " edge partitions of " << partSize_ << " sources in " << dir_;
+	#endif // VERBOSE>0
+}
+
+edgeStore::~edgeStore() {
+	for(auto w : rawWriters_) delete w;
+	for(type_index p=0; p<nPartitions_; ++p) {
+		std::remove(rawPath(p).c_str());
+		std::remove(partitionPath(p).c_str());
+	}
+}
+
+std::string edgeStore::rawPath(type_index p) const {
+	std::stringstream ss;
+	ss << prefix_ << "raw_" << p << ".bin";
+	return ss.str();
+}
+
+std::string edgeStore::partitionPath(type_index p) const {
+	std::stringstream ss;
+	ss << prefix_ << "part_" << p << ".bin";
+	return ss.str();
+}
+
+// Partition file layout: records [src][deg][target_0]...[target_deg-1] with
+// ascending src, only sources with at least one child have a record.
+void edgeStore::finalize() {
+	assert(!finalized_);
+	for(auto w : rawWriters_) w->close();
+
+	skip_.resize(nPartitions_);
+	std::vector<type_index> pairs;
+	std::vector<type_offset> offsets;
+	std::vector<type_index> targets;
+
+	for(type_index p=0; p<nPartitions_; ++p) {
+		const type_index begin = p*partSize_;
+		const type_index size = std::min(partSize_, N_-begin);
+
+		// 1. load raw edges of partition (no file exists if it received no edges)
+		pairs.clear();
+		bufferedReader raw(stats_,defaultBufsize);
+		if(raw.open(rawPath(p))) {
+			type_index v;
+			while(raw.get(v)) pairs.push_back(v);
+			raw.close();
+			std::remove(rawPath(p).c_str());
+		}
+		assert(pairs.size()%2 == 0);
+
+		// 2. group by source (counting sort)
+		offsets.assign(size+1,0);
+		for(std::size_t e=0; e<pairs.size(); e+=2) ++offsets[pairs[e]-begin+1];
+		for(type_index s=0; s<size; ++s) offsets[s+1] += offsets[s];
+		targets.resize(pairs.size()/2);
+		for(std::size_t e=0; e<pairs.size(); e+=2) targets[offsets[pairs[e]-begin]++] = pairs[e+1];
+		for(type_index s=size; s>0; --s) offsets[s] = offsets[s-1];
+		offsets[0] = 0;
+
+		// 3. write records and skip index
+		bufferedWriter part(stats_,defaultBufsize);
+		part.open(partitionPath(p));
+		std::vector<type_offset>& skip = skip_[p];
+		skip.assign(1 + size/skipStride, 0);
+		type_index nextBlock = 0;
+		for(type_index s=0; s<size; ++s) {
+			while(nextBlock <= s/skipStride) skip[nextBlock++] = part.count()*sizeof(type_index);
+			type_index deg = offsets[s+1]-offsets[s];
+			if(deg==0) continue;
+			part.put(begin+s);
+			part.put(deg);
+			for(type_offset e=offsets[s]; e<offsets[s+1]; ++e) part.put(targets[e]);
+		}
+		while(nextBlock < skip.size()) skip[nextBlock++] = part.count()*sizeof(type_index);
+		part.close();
+	}
+
+	// release workspace
+	std::vector<type_index>().swap(pairs);
+	std::vector<type_offset>().swap(offsets);
+	std::vector<type_index>().swap(targets);
+	finalized_ = true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// extSorter
+////////////////////////////////////////////////////////////////////////////////
+
+extSorter::extSorter(edgeStore& es, iostats& stats)
+	: es_(es)
+	, stats_(stats)
+{}
+
+std::string extSorter::bucketPath(unsigned set, type_index p) const {
+	std::stringstream ss;
+	ss << es_.getPrefix() << "front" << set << "_" << p << ".bin";
+	return ss.str();
+}
+
+type_index extSorter::sort(const std::string& outPath, analysis& A) {
+
+	const type_index N = es_.getN();
+	const type_index P = es_.getNPartitions();
+	std::vector<type_index>& indegree = es_.indegree_;
+
+	std::size_t bufsize = std::min<type_offset>(defaultBufsize, std::max<type_offset>(4096, es_.getMemBudget()/(8*(P+2))));
+	std::vector<bufferedWriter*> buckets(P);
+	for(type_index p=0; p<P; ++p) buckets[p] = new bufferedWriter(stats_,bufsize);
+	std::vector<type_offset> bucketCounts(P,0);
+
+	// Start: bucket set 0 = root nodes (written in ascending order)
+	unsigned set = 0;
+	for(type_index p=0; p<P; ++p) buckets[p]->open(bucketPath(set,p));
+	for(type_index v=0; v<N; ++v) {
+		if(indegree[v]==0) buckets[es_.partitionOf(v)]->put(v);
+	}
+	type_offset nFront = 0;
+	for(type_index p=0; p<P; ++p) {
+		bucketCounts[p] = buckets[p]->count();
+		nFront += bucketCounts[p];
+		buckets[p]->close();
+	}
+
+	bufferedWriter out(stats_,defaultBufsize);
+	out.open(outPath);
+
+	bufferedReader bucketReader(stats_,bufsize);
+	bufferedReader partReader(stats_,defaultBufsize);
+	std::vector<type_index> front;
+	std::vector<type_offset> currentCounts(P);
+	type_index depth = 0;
+
+	while(nFront>0) {
+
+		++depth;
+		A.frontSizeHistogram(nFront);
+
+		#if VERBOSE>=2
+		std::cout << "\nextmem: level " << depth << " frontier " << nFront;
+		#endif // VERBOSE>=2
+
+		const unsigned current = set;
+		set ^= 1;
+		std::swap(currentCounts,bucketCounts);
+		for(type_index p=0; p<P; ++p) buckets[p]->open(bucketPath(set,p));
+
+		for(type_index p=0; p<P; ++p) {
+			if(currentCounts[p]==0) continue;
+
+			// 1. load bucket and emit it - a bucket never exceeds the partition size
+			front.clear();
+			front.reserve(currentCounts[p]);
+			if(!bucketReader.open(bucketPath(current,p))) ioFailure("open",bucketPath(current,p));
+			type_index v;
+			while(bucketReader.get(v)) front.push_back(v);
+			bucketReader.close();
+			assert(front.size()==currentCounts[p]);
+			std::sort(front.begin(),front.end());
+			for(auto u : front) out.put(u);
+
+			// 2. merge-scan the sorted bucket against the partition file
+			if(!partReader.open(es_.partitionPath(p))) { // partition without edges
+				for(std::size_t i=0; i<front.size(); ++i) A.incrementProcessedNodes(0);
+				continue;
+			}
+			bool haveRec = false;
+			type_index recSrc = 0, recDeg = 0;
+			type_offset recEnd = 0;
+			for(auto u : front) {
+				A.incrementProcessedNodes(0);
+				if(!haveRec || recSrc<u) {
+					type_offset target = es_.skipOffset(p,u);
+					if(haveRec) target = std::max(target,recEnd);
+					if(target > partReader.tell()) partReader.seek(target);
+					haveRec = false;
+					while(partReader.get(recSrc)) {
+						partReader.get(recDeg);
+						recEnd = partReader.tell() + type_offset(recDeg)*sizeof(type_index);
+						if(recSrc>=u) {
+							haveRec = true;
+							break;
+						}
+						partReader.seek(recEnd);
+					}
+				}
+				if(!haveRec || recSrc!=u) continue; // u has no children
+
+				A.incrementProcessedEdges(0,recDeg);
+				type_index child;
+				for(type_index c=0; c<recDeg; ++c) {
+					partReader.get(child);
+					if(--indegree[child]==0) buckets[es_.partitionOf(child)]->put(child);
+				}
+				haveRec = false;
+			}
+			partReader.close();
+		}
+
+		nFront = 0;
+		for(type_index p=0; p<P; ++p) {
+			bucketCounts[p] = buckets[p]->count();
+			nFront += bucketCounts[p];
+			buckets[p]->close();
+		}
+	}
+	out.close();
+
+	for(type_index p=0; p<P; ++p) {
+		delete buckets[p];
+		std::remove(bucketPath(0,p).c_str());
+		std::remove(bucketPath(1,p).c_str());
+	}
+
+	return depth;
+}
+
+
+void reportIO(const iostats& stats, analysis& A) {
+	A.ioBytesRead_ = stats.bytesRead_;
+	A.ioBytesWritten_ = stats.bytesWritten_;
+	A.time_IORead_ = stats.time_Read_;
+	A.time_IOWrite_ = stats.time_Write_;
+}
+
+} // end namespace extmem
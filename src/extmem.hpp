@@ -0,0 +1,223 @@
+#ifndef EXTMEM_HPP
+#define EXTMEM_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "analysis.hpp"
+#include "node.hpp"
+
+// Out-of-core (external memory) topological sorting.
+//
+// Only the in-degree array of the graph is kept in memory. The edges live on
+// disk in P partition files (partition p holds the out-edges of a contiguous
+// range of source ids, grouped by source). The frontier of every level is
+// kept in P on-disk bucket files, bucket p holding the frontier nodes whose
+// out-edges are in partition p. A level is processed by sorting each bucket
+// and merge-scanning it against its partition, so nearly all I/O is
+// sequential. The order is written level by level to an output file.
+namespace extmem {
+
+	using type_index = Node::type_index;
+	using type_offset = unsigned long long;
+	using type_iosize = analysis::type_iosize;
+
+	// Bookkeeping of all disk traffic of the engine
+	struct iostats {
+		iostats()
+			: bytesRead_(0)
+			, bytesWritten_(0)
+			, time_Read_(0)
+			, time_Write_(0)
+		{}
+
+		type_iosize bytesRead_;
+		type_iosize bytesWritten_;
+		analysis::type_time time_Read_;
+		analysis::type_time time_Write_;
+	};
+
+
+	// Appends binary data to a file through a private buffer. The file is only
+	// created once the first buffer is flushed, so empty buckets cost no I/O.
+	class bufferedWriter {
+
+		public:
+
+			bufferedWriter(iostats& stats, std::size_t bufsize);
+			~bufferedWriter();
+
+			// PRE:		no file is open
+			// POST:	path is opened for writing (truncated unless append is true)
+			void open(const std::string& path, bool append = false);
+			void close();
+
+			inline void put(type_index v) {
+				if(pos_+sizeof(v) > buf_.size()) flush();
+				*reinterpret_cast<type_index*>(&buf_[pos_]) = v;
+				pos_ += sizeof(v);
+				++count_;
+			}
+
+			void flush();
+
+			// number of values put since open()
+			inline type_offset count() const {
+				return count_;
+			}
+
+		private:
+
+			iostats& stats_;
+			std::vector<char> buf_;
+			std::size_t pos_;
+			type_offset count_;
+			std::string path_;
+			bool append_;
+			FILE* file_;
+	};
+
+
+	// Reads binary data sequentially from a file through a private buffer.
+	// Forward seeks inside the buffered window do not touch the disk. The read
+	// size starts at one page after open() or a seek and doubles with every
+	// sequential refill, so sparse frontiers do not pull whole buffers.
+	class bufferedReader {
+
+		public:
+
+			bufferedReader(iostats& stats, std::size_t bufsize);
+			~bufferedReader();
+
+			// POST:	returns false if path cannot be opened
+			bool open(const std::string& path);
+			void close();
+
+			// PRE:		file is open
+			// POST:	v holds the next value, returns false at end of file
+			inline bool get(type_index& v) {
+				if(pos_+sizeof(v) > end_ && !refill()) return false;
+				v = *reinterpret_cast<const type_index*>(&buf_[pos_]);
+				pos_ += sizeof(v);
+				return true;
+			}
+
+			// returns the file offset of the next value
+			inline type_offset tell() const {
+				return bufstart_ + pos_;
+			}
+
+			// PRE:		offset >= tell()
+			// POST:	the next value is read from offset
+			void seek(type_offset offset);
+
+		private:
+
+			bool refill();
+
+			iostats& stats_;
+			std::vector<char> buf_;
+			std::size_t pos_;
+			std::size_t end_;
+			std::size_t readahead_;
+			type_offset bufstart_;
+			FILE* file_;
+	};
+
+
+	// Partitioned on-disk edge storage and the in-memory in-degree array
+	class edgeStore {
+
+		public:
+
+			// PRE:		dir is a writable directory
+			// POST:	partitions are sized such that sorting one of them fits in memBudget bytes
+			edgeStore(type_index N, type_offset nEdgesHint, type_offset memBudget, std::string dir, iostats& stats);
+			~edgeStore();
+
+			// PRE:		finalize() has not been called, src,dst < N
+			// POST:	the edge is appended to the raw file of the partition of src
+			inline void addEdge(type_index src, type_index dst) {
+				assert(src<N_ && dst<N_);
+				bufferedWriter& w = *rawWriters_[partitionOf(src)];
+				w.put(src);
+				w.put(dst);
+				++indegree_[dst];
+				++nEdges_;
+			}
+
+			// Groups each raw partition by source and writes the partition files
+			// together with their skip index
+			void finalize();
+
+			inline type_index partitionOf(type_index v) const {
+				return v/partSize_;
+			}
+
+			inline type_index getN() const { return N_; }
+			inline type_offset getNEdges() const { return nEdges_; }
+			inline type_index getNPartitions() const { return nPartitions_; }
+			inline type_index getPartitionSize() const { return partSize_; }
+			inline type_offset getMemBudget() const { return memBudget_; }
+			inline const std::string& getDir() const { return dir_; }
+			// dir_ plus a name prefix unique to this store, for all its temp files
+			inline const std::string& getPrefix() const { return prefix_; }
+
+			std::string partitionPath(type_index p) const;
+
+			// PRE:		finalize() has been called
+			// POST:	returns the smallest file offset in partition p from which
+			//			the record of source v (if any) can be reached by reading forward
+			inline type_offset skipOffset(type_index p, type_index v) const {
+				return skip_[p][(v - p*partSize_)/skipStride];
+			}
+
+			std::vector<type_index> indegree_;	// the only O(N) structure held in memory
+
+			static const type_index skipStride = 256; // sources per entry of the skip index
+
+		private:
+
+			std::string rawPath(type_index p) const;
+
+			const type_index N_;
+			type_offset nEdges_;
+			type_offset memBudget_;
+			type_index nPartitions_;
+			type_index partSize_;
+			std::string dir_;
+			std::string prefix_;
+			iostats& stats_;
+			std::vector<bufferedWriter*> rawWriters_;
+			std::vector<std::vector<type_offset> > skip_;
+			bool finalized_;
+	};
+
+
+	// Level-synchronous sorter working on an edgeStore
+	class extSorter {
+
+		public:
+
+			extSorter(edgeStore& es, iostats& stats);
+
+			// PRE:		es.finalize() has been called
+			// POST:	outPath holds all node ids in topological order,
+			//			returns the number of levels (depth) of the graph
+			type_index sort(const std::string& outPath, analysis& A);
+
+		private:
+
+			std::string bucketPath(unsigned set, type_index p) const;
+
+			edgeStore& es_;
+			iostats& stats_;
+	};
+
+	// Copies the I/O bookkeeping into the analysis
+	void reportIO(const iostats& stats, analysis& A);
+
+} // end namespace extmem
+
+#endif // EXTMEM_HPP
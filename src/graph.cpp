@@ -1,14 +1,17 @@
 #include "graph.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
 #include <list>
 #include <vector>
 #include <random>
 #include <functional>
 #include <numeric>
 #include <memory>
+#include <utility>
 #include <omp.h>
 
 using type_size = Graph::type_size;
@@ -40,7 +43,7 @@ void Graph::connect(GRAPH_TYPE type, double edgeFillDegree, double p, double q,
         case RANDOM_LIN:
         {
 			// Specify (roughly) number of edges            
-            int nEdges = N_ * edgeFillDegree;
+            type_size nEdges = static_cast<type_size>(N_ * edgeFillDegree);
             connectRandom(nEdges);
             graphName_ = "RANDOMLIN";
             std::cout << "RANDOM_LIN (target fill degree: " << static_cast<double>(nEdges) / (0.5 * N_ * (N_-1)) << ")";
@@ -51,7 +54,7 @@ void Graph::connect(GRAPH_TYPE type, double edgeFillDegree, double p, double q,
 		case RANDOM_QUAD:
 		{
 			// Specify (roughly) number of edges
-            int nEdges = N_ * (N_ - 1) * 0.5 * edgeFillDegree;
+            type_size nEdges = static_cast<type_size>(0.5 * N_ * (N_ - 1) * edgeFillDegree);
             connectRandom(nEdges);
             graphName_ = "RANDOMQUAD";
 			std::cout << "RANDOM_QUAD (target fill degree: " << edgeFillDegree << ")";
@@ -142,14 +145,18 @@ void Graph::connect(GRAPH_TYPE type, double edgeFillDegree, double p, double q,
 
     assert(graphName_ != "");
 	nEdges_ = countEdges();
+	topology_.reset(); // edges changed
+	reverseTopology_.reset();
+	reachSorter_.reset();
+	wavefronts_.reset();
 
 	std::cout << "\n(Nodes: " << N_ << ", Edges: " << nEdges_ << ", FillDegree: " << static_cast<double>(nEdges_) / (0.5 * N_ * (N_-1)) << ")";
 	std::cout << "\n";
 
 }
 
-void Graph::connectRandom(int nEdges){
-    assert(nEdges <= N_ * (N_ - 1) * 0.5);
+void Graph::connectRandom(type_size nEdges){
+    assert(nEdges <= 0.5 * N_ * (N_ - 1));
     // Create random order of nodes
     std::vector<unsigned> order(N_);
     std::iota(order.begin(), order.end(), 0);
@@ -208,6 +215,163 @@ std::vector<type_size> Graph::getChildrenQuantiles() {
     return quantiles;
 }
 
+Graph::profile Graph::getProfile(type_size nWalks) {
+    profile prof;
+    prof.childrenQuantiles_ = getChildrenQuantiles();
+    prof.nNodes_ = N_;
+    prof.nEdges_ = nEdges_;
+
+    // Sources are the nodes that still have value 1 (see Node::addChild)
+    std::vector<type_size> sources;
+    #pragma omp parallel
+    {
+        std::vector<type_size> sources_local;
+        #pragma omp for nowait
+        for(type_size i = 0; i < N_; ++i) {
+            if(nodes_[i]->getValue() == 1)
+                sources_local.push_back(i);
+        }
+        #pragma omp critical
+        sources.insert(sources.end(), sources_local.begin(), sources_local.end());
+    }
+    prof.nSources_ = sources.size();
+
+    // Random walks down to a sink from evenly spaced sources
+    type_size depth = 0;
+    if(!sources.empty()) {
+        std::sort(sources.begin(), sources.end());
+        #pragma omp parallel for reduction(max:depth)
+        for(type_size w = 0; w < nWalks; ++w) {
+            std::mt19937 gen(w);
+            auto nd = nodes_[sources[(static_cast<std::size_t>(w) * sources.size()) / nWalks]];
+            type_size length = 1;
+            while(nd->getChildCount() > 0) {
+                std::uniform_int_distribution<unsigned> dis(0, nd->getChildCount() - 1);
+                nd = nd->getChild(dis(gen));
+                ++length;
+            }
+            depth = std::max(depth, length);
+        }
+    }
+    prof.depthEstimate_ = depth;
+    prof.widthEstimate_ = depth > 0 ? static_cast<double>(N_) / depth : 0.;
+    return prof;
+}
+
+std::shared_ptr<const topology> Graph::getTopology() {
+    if(topology_) return topology_;
+
+    std::vector<topology::type_offset> offsets(N_+1, 0);
+    for(type_size i = 0; i < N_; ++i) {
+        offsets[i+1] = offsets[i] + nodes_[i]->getChildCount();
+    }
+    std::vector<topology::type_index> targets(offsets[N_]);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(type_size i = 0; i < N_; ++i) {
+        topology::type_offset pos = offsets[i];
+        for(type_size c = 0; c < nodes_[i]->getChildCount(); ++c) {
+            targets[pos++] = nodes_[i]->getChild(c)->getID();
+        }
+    }
+    topology_ = std::make_shared<const topology>(std::move(offsets), std::move(targets));
+    return topology_;
+}
+
+Graph::type_nodelist Graph::sortReachable(const std::vector<Node::type_index>& seeds, reach::direction dir) {
+    std::shared_ptr<const topology> topo = getTopology();
+    if(dir == reach::UPSTREAM && !reverseTopology_) {
+        reverseTopology_ = std::make_shared<const topology>(topo->transposed());
+        reachSorter_.reset();
+    }
+    if(!reachSorter_) reachSorter_ = std::make_shared<reach::sorter>(*topo, reverseTopology_.get());
+
+    std::vector<topology::type_index> order;
+    std::vector<topology::type_index> levels;
+    reachSorter_->sort(seeds, dir, order, levels);
+    type_nodelist result;
+    for(auto v : order) result.push_back(nodes_[v]);
+    return result;
+}
+
+void Graph::resetSort() {
+    const std::vector<topology::type_index>& indegrees = getTopology()->indegrees();
+    #pragma omp parallel for schedule(static)
+    for(type_size i = 0; i < N_; ++i) {
+        nodes_[i]->resetState(indegrees[i]);
+    }
+    solution_.clear();
+    depth_ = 0;
+    A_ = analysis();
+    wavefronts_.reset();
+}
+
+void Graph::keepWavefronts(const sortState& st, topology::type_index depth) {
+    if(!collectWavefronts_ || st.size() != N_) return;
+    wavefronts_ = std::make_shared<wavefront::levelCSR>();
+    wavefront::fromLevels(st.levels().data(), st.getTopology().size(), depth, *wavefronts_);
+}
+
+std::shared_ptr<const wavefront::levelCSR> Graph::getWavefronts() {
+    if(wavefronts_ || solution_.size() != N_) return wavefronts_;
+    // Node engines: the levels from the solution, every node is final before its children
+    std::shared_ptr<const topology> topo = getTopology();
+    std::vector<topology::type_index> levels(N_, 0);
+    topology::type_index depth = 0;
+    for(const auto& nd : solution_) {
+        const topology::type_index v = nd->getID();
+        const topology::type_index childlevel = levels[v] + 1;
+        depth = std::max(depth, childlevel);
+        for(const topology::type_index* c = topo->childBegin(v); c != topo->childEnd(v); ++c) {
+            levels[*c] = std::max(levels[*c], childlevel);
+        }
+    }
+    wavefronts_ = std::make_shared<wavefront::levelCSR>();
+    wavefront::fromLevels(levels.data(), topo->size(), depth, *wavefronts_);
+    return wavefronts_;
+}
+
+void Graph::analyzeWavefronts() {
+    std::shared_ptr<const wavefront::levelCSR> waves = getWavefronts();
+    if(!waves) return;
+    const wavefront::statistics stats = wavefront::summarize(*waves);
+    A_.setParameter("waves", stats.depth_);
+    A_.setParameter("waveSizeMin", stats.min_);
+    A_.setParameter("waveSizeMedian", stats.median_);
+    A_.setParameter("waveSizeMean", stats.mean_);
+    A_.setParameter("waveSizeMax", stats.max_);
+    A_.setParameter("singletonWaves", stats.singletons_);
+    if(A_.frontSizes_.empty()) { // engines without a frontier histogram of their own
+        for(topology::type_index k = 0; k < waves->depth(); ++k) A_.frontSizes_.push_back(waves->size(k));
+    }
+}
+
+void Graph::recordMemory() {
+    // make_shared puts the node behind its control block (libstdc++: vtable pointer and two counts)
+    const type_size controlBlock = sizeof(void*) + 2 * sizeof(int);
+    type_size nodes = nodes_.capacity() * sizeof(type_nodeptr);
+    #pragma omp parallel for reduction(+:nodes) schedule(static)
+    for(type_size i = 0; i < N_; ++i) {
+        nodes += controlBlock + nodes_[i]->bytes();
+    }
+    A_.recordMemory("nodes", nodes);
+    if(topology_) A_.recordMemory("topology", topology_->bytes());
+    if(reverseTopology_) A_.recordMemory("reverseTopology", reverseTopology_->bytes());
+    A_.recordMemory("solution", solution_.size() * listNodeBytes);
+    if(wavefronts_) {
+        A_.recordMemory("wavefronts", (wavefronts_->offsets_.capacity() + wavefronts_->nodes_.capacity()) * sizeof(topology::type_index));
+    }
+}
+
+int Graph::getChunkSize(int defaultChunk) {
+    return static_cast<int>(getEnvSize("TOPOSORT_CHUNK", defaultChunk));
+}
+
+Graph::type_size Graph::getEnvSize(const char* name, type_size defaultValue, type_size minValue) {
+    const char* env = std::getenv(name);
+    const long long val = env ? std::atoll(env) : -1;
+    return (val >= 0 && static_cast<type_size>(val) >= minValue) ? static_cast<type_size>(val) : defaultValue;
+}
+
 bool Graph::checkCorrect(bool verbose) {
 	
     std::cout << "\nChecking solution correctness...\n";
@@ -277,6 +441,86 @@ bool Graph::checkCorrect(bool verbose) {
 }
 
 
+bool Graph::checkReachable(const std::vector<Node::type_index>& seeds, reach::direction dir,
+                           const type_nodelist& region, bool verbose) {
+
+    std::cout << "\nChecking reachable region (" << (dir == reach::DOWNSTREAM ? "downstream" : "upstream")
+              << " of " << seeds.size() << " seeds)...\n";
+    bool correct = true;
+
+    // 1. the expected region, by a serial traversal of the Node graph
+    std::vector<std::vector<size_t> > parents;
+    if(dir == reach::UPSTREAM) {
+        parents.resize(N_);
+        for(size_t i = 0; i < N_; ++i) {
+            for(size_t k = 0; k < nodes_[i]->getChildCount(); ++k) {
+                parents[nodes_[i]->getChild(k)->getID()].push_back(i);
+            }
+        }
+    }
+    std::vector<char> expected(N_, false);
+    std::vector<size_t> stack;
+    for(auto s : seeds) {
+        if(!expected[s]) { expected[s] = true; stack.push_back(s); }
+    }
+    while(!stack.empty()) {
+        size_t v = stack.back();
+        stack.pop_back();
+        if(dir == reach::DOWNSTREAM) {
+            for(size_t k = 0; k < nodes_[v]->getChildCount(); ++k) {
+                size_t w = nodes_[v]->getChild(k)->getID();
+                if(!expected[w]) { expected[w] = true; stack.push_back(w); }
+            }
+        } else {
+            for(auto w : parents[v]) {
+                if(!expected[w]) { expected[w] = true; stack.push_back(w); }
+            }
+        }
+    }
+
+    // 2. every node of the region is expected and occurs once
+    const size_t none = ~size_t(0);
+    std::vector<size_t> nodeOrders(N_, none);
+    size_t cnt = 0;
+    for(const auto& nd : region) {
+        size_t nodeId = nd->getID();
+        if(!expected[nodeId] || nodeOrders[nodeId] != none) {
+            correct = false;
+            if(verbose)
+                std::cout << "ERROR: Node #" << nodeId << (expected[nodeId] ? " occurs more than once" : " is not reachable") << "\n";
+        }
+        nodeOrders[nodeId] = cnt++;
+    }
+    for(size_t i = 0; i < N_; ++i) {
+        if(expected[i] && nodeOrders[i] == none) {
+            correct = false;
+            if(verbose)
+                std::cout << "ERROR: Reachable node #" << i << " is missing\n";
+        }
+    }
+
+    // 3. edges within the region point forward
+    for(size_t i = 0; i < N_; ++i) {
+        if(nodeOrders[i] == none) continue;
+        for(size_t k = 0; k < nodes_[i]->getChildCount(); ++k) {
+            size_t childId = nodes_[i]->getChild(k)->getID();
+            if(nodeOrders[childId] != none && nodeOrders[i] > nodeOrders[childId]) {
+                correct = false;
+                if(verbose)
+                    std::cout << "ERROR: Node #" << i << " should have lower index than node #" << childId << "\n";
+            }
+        }
+    }
+
+    if(correct) {
+        std::cout << "\n\033[1;32mOK\033[0m: VALID REACHABLE REGION (" << region.size() << " nodes).\n\n";
+    } else {
+        std::cout << "\n\033[1;31mERROR: INVALID REACHABLE REGION!\033[0m\n\n";
+    }
+    return correct;
+}
+
+
 #if DEBUG>0 || VERBOSE>0
 // Overloading output operator of nodelist
 // Can be useful for debugging
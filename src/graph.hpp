@@ -7,10 +7,15 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <cstdlib>
 #include <omp.h>
 
 #include "node.hpp"
 #include "analysis.hpp"
+#include "topology.hpp"
+#include "reach.hpp"
+#include "sortstate.hpp"
+#include "wavefront.hpp"
 
 
 class Graph {
@@ -24,6 +29,8 @@ class Graph {
         using type_nodelist = std::list<type_nodeptr>;
         using type_solution = type_nodelist; // NB: I would prefer type_nodelist over type_solution - more generic (not all nodelists are solutions, for example currentnodes)
         using type_size = analysis::type_size;
+        // heap bytes of one entry of a type_nodelist: the pointer and the links to its neighbours
+        static constexpr type_size listNodeBytes = sizeof(type_nodeptr) + 2 * sizeof(void*);
         
         explicit Graph(unsigned N)
 			:	N_(N)
@@ -31,6 +38,7 @@ class Graph {
 			,	depth_(0)
 			,	nodes_(type_nodearray(N_))
 			,	A_()
+			,	collectWavefronts_(std::getenv("TOPOSORT_WAVEFRONTS") && std::string(std::getenv("TOPOSORT_WAVEFRONTS")) == "1")
 		{
 			std::cout << "DEBUG = " << DEBUG << "\tVERBOSE = " << VERBOSE << "\tOPTIMISTIC = " << OPTIMISTIC << "\tENABLE_ANALYSIS = " << ENABLE_ANALYSIS << "\n\n";
 			std::cout << "Initializing graph of size " << N_ << "...\n";
@@ -49,10 +57,13 @@ class Graph {
             A_.nChildrenQuantiles_ = getChildrenQuantiles();
             
             // Start topological sorting
+			wavefronts_.reset();
 			A_.starttotaltiming();
 			this->topSort();
 			A_.stoptotaltiming();
             A_.depth_ = depth_;
+            if(collectWavefronts_) analyzeWavefronts();
+            recordMemory();
 			std::cout << "\n\nMaximum Diameter: " << depth_;
 			std::cout << "\n\n\tSorting completed in:\t" << std::setprecision(8) << std::fixed << A_.time_Total_ << " sec\n\n";
 			return A_.time_Total_;
@@ -72,7 +83,54 @@ class Graph {
         /** \brief Returns the 0 (aka min), 25, 50 (aka median), 75 and 100 (aka max) quantile of the number of children of each node.
          */  
         std::vector<type_size> getChildrenQuantiles();
+        
+        /** \brief Cheap summary of the graph shape, used by the auto mode (main_auto.cpp) to choose an engine.
+         *  The depth is the longest of nWalks random walks from the sources, i.e. a lower bound.
+         */
+        struct profile {
+            std::vector<type_size> childrenQuantiles_;
+            type_size nNodes_;
+            type_size nEdges_;
+            type_size nSources_;
+            type_size depthEstimate_;
+            double widthEstimate_; // nodes per level, nNodes_ / depthEstimate_
+        };
+        profile getProfile(type_size nWalks = 256);
+        /** \brief Chunk size for the dynamic schedules of the engines, TOPOSORT_CHUNK overrides defaultChunk.
+         */
+        static int getChunkSize(int defaultChunk);
+        /** \brief Numeric engine setting from the environment variable name, defaultValue if it is unset or below minValue.
+         */
+        static type_size getEnvSize(const char* name, type_size defaultValue, type_size minValue = 1);
         bool checkCorrect(bool verbose);
+        /** \brief Checks a result of sortReachable against a plain traversal of the Node graph:
+         *  region holds every node reachable from the seeds in dir exactly once, and no other node,
+         *  and every edge within the region points forward.
+         */
+        bool checkReachable(const std::vector<Node::type_index>& seeds, reach::direction dir,
+                            const type_nodelist& region, bool verbose);
+        
+        /** \brief Read-only CSR copy of the edges, built on first use (and after connect).
+         *  Sorts on it with their own sortState (csrsort.hpp) leave the graph untouched.
+         */
+        std::shared_ptr<const topology> getTopology();
+        /** \brief Undoes a topSort(): restores the parent counters and root values of all nodes
+         *  from the topology and clears solution, depth and analysis, so the graph can be sorted again.
+         */
+        void resetSort();
+        /** \brief Partial sort: the seeds and every node reachable from them (reach::DOWNSTREAM: descendants,
+         *  reach::UPSTREAM: ancestors) in topological order. Only the region is traversed and sorted,
+         *  the Node objects are not touched.
+         */
+        type_nodelist sortReachable(const std::vector<Node::type_index>& seeds, reach::direction dir);
+        /** \brief Optional output: the solution grouped by level (wavefront.hpp), wave k can run once waves 0..k-1 are done.
+         *  The CSR engines build it during the sort, for the Node engines getWavefronts() needs one pass over the solution.
+         *  Off by default, TOPOSORT_WAVEFRONTS=1 turns it on. Level-size statistics then go to the analysis parameters.
+         */
+        void setCollectWavefronts(bool collect) {
+        	collectWavefronts_ = collect;
+        }
+        std::shared_ptr<const wavefront::levelCSR> getWavefronts();
         type_solution getSolution();
         
         // Print and doc methods (graphdoc.cpp)
@@ -80,6 +138,7 @@ class Graph {
         void printSolution();
 		void viz(std::string) const;
         void dumpXmlAnalysis(std::string relativeDir);
+        bool dumpSqliteAnalysis(std::string dbFile, std::string comment = "");
         void setDepth(type_size d) {
         	depth_ = d;
         }
@@ -88,13 +147,23 @@ class Graph {
 
 	protected:
 
-        void connectRandom(int nEdges);
+        void connectRandom(type_size nEdges);
+        // CSR engines: keeps the waves of a complete sort if they are to be collected
+        void keepWavefronts(const sortState& st, topology::type_index depth);
+        void analyzeWavefronts();
+        // bytes of the Node graph, topology, solution and waves, the engines add their own
+        void recordMemory();
 		type_size N_; // size of graph, == W
 		type_size nEdges_; // number of edges
         type_size depth_; // depth of graph, == D
         std::string graphName_;
 		type_nodearray nodes_;
         analysis A_;
+        std::shared_ptr<const topology> topology_;
+        std::shared_ptr<const topology> reverseTopology_; // parents as children, for upstream queries
+        std::shared_ptr<reach::sorter> reachSorter_; // workspace of sortReachable
+        bool collectWavefronts_;
+        std::shared_ptr<wavefront::levelCSR> wavefronts_; // of the last sort, if collected
 
 };
 
@@ -26,10 +26,14 @@ void Graph::printNodeInfo() {
 
 void Graph::printSolution() {
     std::cout << "\nSolution (Node IDs)" << std::endl;
-    for(auto elem : solution_){
-        std::cout << elem->getID() << " ";
+    // one write instead of one stream operation per id (large graphs: TOPOSORT_STREAM of csr_levels)
+    std::string line;
+    line.reserve(solution_.size() * 8);
+    for(const auto& elem : solution_){
+        line += std::to_string(elem->getID());
+        line += ' ';
     }
-    std::cout << std::endl;
+    std::cout << line << std::endl;
 }
 
 // Create graphviz file for drawing graph
@@ -53,12 +57,12 @@ void Graph::viz(std::string graphfilename) const {
 	
 	outfile_ptr = fopen(path.c_str(),"w");
 	if(outfile_ptr != NULL) {
-		fprintf(outfile_ptr,"# Visualization of Graph %s, size=%u\n\n",path.c_str(),N_);
+		fprintf(outfile_ptr,"# Visualization of Graph %s, size=%llu\n\n",path.c_str(),N_);
 		fprintf(outfile_ptr,"digraph g {\n");
 		// fprintf(outfile_ptr,"\tranksep=1;\n");
 		// fprintf(outfile_ptr,"\tratio=auto;\n");
 	
-		fprintf(outfile_ptr,"\n\t#TITLE\n\tlabelloc=\"t\";\n\tlabel=\"type=%s, size=%u;\"\n",graphfilename.c_str(),N_);
+		fprintf(outfile_ptr,"\n\t#TITLE\n\tlabelloc=\"t\";\n\tlabel=\"type=%s, size=%llu;\"\n",graphfilename.c_str(),N_);
 
 		fprintf(outfile_ptr,"\n\t# NODES\n");
 		unsigned maxv = 0;
@@ -104,3 +108,7 @@ void Graph::viz(std::string graphfilename) const {
 void Graph::dumpXmlAnalysis(std::string relativeDir){
     A_.xmlAnalysis(relativeDir);
 }
+
+bool Graph::dumpSqliteAnalysis(std::string dbFile, std::string comment){
+    return A_.sqliteAnalysis(dbFile, comment);
+}
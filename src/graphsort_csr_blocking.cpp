@@ -0,0 +1,40 @@
+#include <omp.h>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "blocking.hpp"
+#include "sortstate.hpp"
+
+std::string Graph::getName(){
+    return "csr_blocking";
+}
+
+// Owner-computes sort of the CSR topology with propagation blocking
+// (blocking.hpp): every in-degree is only decremented by the thread that owns
+// the node, decrements for other owners are binned and applied by them after
+// the level. No atomic per edge, no counter shared between caches.
+// Environment:	TOPOSORT_BLOCKSHIFT	log2 of the nodes per ownership block (default 10)
+void Graph::topSort() {
+
+	const type_size val = getEnvSize("TOPOSORT_BLOCKSHIFT", blocking::defaultBlockShift, 0);
+	const unsigned blockShift = val < 32 ? val : blocking::defaultBlockShift;
+
+	A_.startthreadcounters(0);
+	std::shared_ptr<const topology> topo = getTopology();
+	sortState st(*topo);
+	blocking::counters counts;
+	depth_ = blocking::sort(st, 0, blockShift, &counts);
+	keepWavefronts(st, depth_);
+	A_.stopthreadcounters(0);
+
+	A_.setParameter("blockShift", blockShift);
+	A_.setParameter("localUpdates", counts.local_);
+	A_.setParameter("binnedUpdates", counts.remote_);
+	A_.recordMemory("counters", st.bytes());
+	A_.recordMemory("threadLocal", counts.bytes_);
+
+	const std::vector<topology::type_index>& order = st.order();
+	for(topology::type_index i = 0; i < st.size(); ++i) {
+		solution_.push_back(nodes_[order[i]]);
+	}
+}
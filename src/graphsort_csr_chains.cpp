@@ -0,0 +1,35 @@
+#include <omp.h>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "chains.hpp"
+#include "sortstate.hpp"
+
+std::string Graph::getName(){
+    return "csr_chains";
+}
+
+// Collapses the chains of the CSR topology into super-nodes (chains.hpp),
+// sorts the contracted topology level by level and expands the chains again.
+// Meant for deep graphs where most levels hold a single node: the number of
+// barriers follows the branching levels, not the depth.
+void Graph::topSort() {
+
+	A_.startthreadcounters(0);
+	std::shared_ptr<const topology> topo = getTopology();
+	chains::contraction con(*topo);
+	sortState st(*topo);
+	depth_ = chains::sort(con, st);
+	keepWavefronts(st, depth_);
+	A_.stopthreadcounters(0);
+
+	A_.setParameter("superNodes", con.contracted().size());
+	A_.setParameter("superEdges", con.contracted().nEdges());
+	A_.recordMemory("counters", st.bytes());
+	A_.recordMemory("chains", con.bytes());
+
+	const std::vector<topology::type_index>& order = st.order();
+	for(topology::type_index i = 0; i < st.size(); ++i) {
+		solution_.push_back(nodes_[order[i]]);
+	}
+}
@@ -0,0 +1,42 @@
+#include <omp.h>
+#include <algorithm>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "components.hpp"
+#include "sortstate.hpp"
+
+std::string Graph::getName(){
+    return "csr_components";
+}
+
+// Splits the CSR topology into its weakly connected components
+// (components.hpp) and sorts them as independent jobs: the large ones with
+// csrsort::levels and all threads, the small ones with csrsort::serial, one
+// per thread and without any barrier. The orders are concatenated.
+// Environment:	TOPOSORT_WCC_PARALLEL	component size from which a component is sorted in parallel (default 65536)
+void Graph::topSort() {
+
+	const topology::type_index parallelThreshold = getEnvSize("TOPOSORT_WCC_PARALLEL", 65536);
+
+	A_.startthreadcounters(0);
+	std::shared_ptr<const topology> topo = getTopology();
+	components::decomposition dec(*topo);
+	sortState st(*topo);
+	depth_ = components::sort(dec, st, parallelThreshold);
+	keepWavefronts(st, depth_);
+	A_.stopthreadcounters(0);
+
+	topology::type_index largest = 0;
+	for(topology::type_index c = 0; c < dec.count(); ++c) largest = std::max(largest, dec.size(c));
+	A_.setParameter("parallelThreshold", parallelThreshold);
+	A_.setParameter("components", dec.count());
+	A_.setParameter("largestComponent", largest);
+	A_.recordMemory("counters", st.bytes());
+	A_.recordMemory("components", dec.bytes());
+
+	const std::vector<topology::type_index>& order = st.order();
+	for(topology::type_index i = 0; i < st.size(); ++i) {
+		solution_.push_back(nodes_[order[i]]);
+	}
+}
@@ -0,0 +1,65 @@
+#include <omp.h>
+#include <cstdlib>
+#include <memory>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "csrsort.hpp"
+#include "sortstate.hpp"
+#include "simd_kernels.hpp"
+#include "prefetch.hpp"
+#include "sink.hpp"
+#include "wavefront.hpp"
+
+std::string Graph::getName(){
+    return "csr_levels";
+}
+
+// Runs csrsort::levels on the CSR topology of the graph. The Node objects are
+// not modified, the topology is built on the first sort and reused after
+// resetSort(). Mainly here to compare the CSR engines with the Node engines.
+// Environment:	TOPOSORT_STREAM	path of a binary file, or fd:<n> for an open descriptor
+//								(pipe), that receives every level while the sort runs (sink.hpp)
+void Graph::topSort() {
+
+	A_.setParameter("simd", kernels::active());
+	A_.setParameter("prefetchDistance", prefetch::distance());
+
+	const char* env_stream = std::getenv("TOPOSORT_STREAM");
+	std::unique_ptr<sink::fileWriter> file;
+	std::unique_ptr<sink::pipeWriter> pipe;
+	sink::levelSink* out = nullptr;
+	if(env_stream && std::string(env_stream).compare(0, 3, "fd:") == 0) {
+		pipe.reset(new sink::pipeWriter(std::atoi(env_stream + 3)));
+		out = pipe.get();
+	} else if(env_stream) {
+		file.reset(new sink::fileWriter(env_stream));
+		if(file->good()) out = file.get();
+	}
+
+	A_.startthreadcounters(0);
+	std::shared_ptr<const topology> topo = getTopology();
+	sortState st(*topo);
+	// the waves are collected from the same hand-over as the stream
+	std::unique_ptr<wavefront::collector> waves;
+	if(collectWavefronts_) {
+		wavefronts_ = std::make_shared<wavefront::levelCSR>();
+		waves.reset(new wavefront::collector(*wavefronts_, topo->size()));
+	}
+	sink::tee both(out, waves.get());
+	depth_ = csrsort::levels(st, 0, (out || waves) ? &both : nullptr);
+	if(file) file->close();
+	if(st.size() != N_) wavefronts_.reset(); // cycle, the waves are incomplete
+	A_.stopthreadcounters(0);
+
+	A_.recordMemory("counters", st.bytes());
+	if(out) {
+		A_.ioBytesWritten_ = file ? file->bytes() : pipe->bytes();
+		A_.time_IOWrite_ = file ? file->seconds() : pipe->seconds();
+	}
+
+	const std::vector<topology::type_index>& order = st.order();
+	for(topology::type_index i = 0; i < st.size(); ++i) {
+		solution_.push_back(nodes_[order[i]]);
+	}
+}
@@ -0,0 +1,62 @@
+#include <omp.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "policysort.hpp"
+#include "sortstate.hpp"
+
+std::string Graph::getName(){
+    return "csr_policy";
+}
+
+// Runs one of the policysort instantiations on the CSR topology, picked at
+// run time. Compares the update and frontier variants without rebuilding.
+// Environment:	TOPOSORT_POLICY	<atomic>,<frontier>[,count], atomic: serial|atomic|critical,
+//								frontier: levels|stack (default atomic,levels)
+void Graph::topSort() {
+
+	std::string atomic = "atomic";
+	std::string frontier = "levels";
+	bool count = false;
+	const char* env = std::getenv("TOPOSORT_POLICY");
+	if(env) {
+		const std::string policy(env);
+		const std::size_t first = policy.find(',');
+		const std::size_t second = first == std::string::npos ? std::string::npos : policy.find(',', first + 1);
+		atomic = policy.substr(0, first);
+		if(first != std::string::npos) frontier = policy.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+		count = second != std::string::npos && policy.substr(second + 1) == "count";
+	}
+
+	A_.startthreadcounters(0);
+	std::shared_ptr<const topology> topo = getTopology();
+	sortState st(*topo);
+	policysort::countingInstrumentation counts;
+	topology::type_index depth = 0;
+	const bool known = policysort::run(atomic, frontier, st, omp_get_max_threads(), count ? &counts : nullptr, depth);
+	depth_ = depth;
+	keepWavefronts(st, depth_);
+	A_.stopthreadcounters(0);
+
+	if(!known) {
+		std::cerr << "ERROR:\tunknown policy combination " << atomic << "," << frontier << "\n";
+		return;
+	}
+	A_.setParameter("atomic", atomic == "serial" ? 0 : atomic == "atomic" ? 1 : 2);
+	A_.setParameter("frontier", frontier == "levels" ? 0 : 1);
+	A_.recordMemory("counters", st.bytes());
+	if(count) {
+		A_.setParameter("processedNodes", counts.nodes());
+		A_.setParameter("processedEdges", counts.edges());
+		A_.setParameter("rounds", counts.rounds());
+		A_.setParameter("imbalance", counts.imbalance());
+	}
+
+	const std::vector<topology::type_index>& order = st.order();
+	for(topology::type_index i = 0; i < st.size(); ++i) {
+		solution_.push_back(nodes_[order[i]]);
+	}
+}
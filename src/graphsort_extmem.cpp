@@ -0,0 +1,57 @@
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "extmem.hpp"
+
+std::string Graph::getName(){
+    return "extmem";
+}
+
+// Runs the out-of-core engine on an in-memory graph, mainly to validate it
+// against checkCorrect(). The edges are streamed into the on-disk partitions,
+// from there on the engine only holds the in-degree array.
+// Environment:	TOPOSORT_TMPDIR		directory for partition and frontier files (default /tmp)
+//				TOPOSORT_MEMBUDGET	memory budget of the engine in MB (default 1024)
+void Graph::topSort() {
+
+	const char* env_dir = std::getenv("TOPOSORT_TMPDIR");
+	std::string dir = env_dir ? env_dir : "/tmp";
+	extmem::type_offset budget = getEnvSize("TOPOSORT_MEMBUDGET", 1024) << 20;
+
+	A_.startthreadcounters(0);
+
+	extmem::iostats stats;
+	{
+		extmem::edgeStore es(N_,nEdges_,budget,dir,stats);
+		for(auto nd : nodes_) {
+			type_size childcount = nd->getChildCount();
+			for(type_size c=0; c<childcount; ++c) {
+				es.addEdge(nd->getID(),nd->getChild(c)->getID());
+			}
+		}
+		es.finalize();
+
+		std::string outPath = es.getPrefix() + "order.bin";
+		extmem::extSorter sorter(es,stats);
+		depth_ = sorter.sort(outPath,A_);
+
+		// Read order back into the solution list
+		extmem::bufferedReader in(stats,1 << 20);
+		if(in.open(outPath)) {
+			extmem::type_index id;
+			while(in.get(id)) solution_.push_back(nodes_[id]);
+			in.close();
+		}
+		std::remove(outPath.c_str());
+	}
+	extmem::reportIO(stats,A_);
+	A_.stopthreadcounters(0);
+
+	#if VERBOSE>0
+	std::cout << "\nextmem: read " << stats.bytesRead_ << " bytes (" << stats.time_Read_ << " sec), wrote "
+	          << stats.bytesWritten_ << " bytes (" << stats.time_Write_ << " sec)";
+	#endif // VERBOSE>0
+}
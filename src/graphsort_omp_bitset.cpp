@@ -1,7 +1,9 @@
 #include <omp.h>
+#include <mutex>
 
 #include "graph.hpp"
 #include "analysis.hpp"
+#include "backend.hpp"
 
 std::string Graph::getName(){
     return "bitset";
@@ -10,44 +12,50 @@ std::string Graph::getName(){
 void Graph::topSort() {
 	// Sorting Magic happens here
 	
-    int nThreads;
-    #pragma omp parallel
-    {
-        nThreads = omp_get_num_threads();
-    } 
+    const int nThreads = backend::nThreads();
+    const int chunk = getChunkSize(256);
+    A_.setParameter("chunk", chunk);
+    A_.setParameter("threadPool", backend::threadPool);
     // Indicator vector true if node is a current node (aka frontier node)
     std::vector<char> isCurrentNode(2*N_, false); //std::vector<bool> is not thread-safe
-    std::vector<char> newChildrenPerThread(nThreads, true);
+    A_.recordMemory("frontier", isCurrentNode.capacity());
+    std::vector<char> newChildrenPerThread(nThreads, true); // the first team entries are used
     bool newChildren = true;
     int shift = 0;
-	// Spawn OMP threads
-	#pragma omp parallel
+    unsigned level = 0;
+    backend::dynamicLoop frontier(N_, chunk);
+    std::mutex solutionMutex;
+	// Spawn threads (OpenMP team or thread pool, see backend.hpp)
+	backend::run([&](const int threadID, const int team)
 	{
 		// Declare Thread Private Variables
-		const int threadID = omp_get_thread_num();
 		type_nodelist solution_local;
+		A_.startthreadcounters(threadID);
 
 		// Distribute Root Nodes among Threads
-        #pragma omp for
-		for(unsigned i=0; i<N_; ++i) {
+		backend::staticFor(threadID, team, N_, [&](std::size_t i) {
 			if(nodes_[i]->getValue()==1)
                 isCurrentNode[i] = true;
-		} // implicit barrier
+		});
+		backend::barrier();
     
         while(newChildren){
             newChildrenPerThread[threadID] = false;
+            unsigned levelnodes = 0;
+            A_.tracer_.event(threadID, tracer::LEVELBEGIN, level);
             #if ENABLE_ANALYSIS == 1
                 int shiftN = shift * N_;
-                #pragma omp single
-                A_.frontSizeHistogram(std::count(isCurrentNode.begin() + shiftN, isCurrentNode.begin() + shiftN + N_, true));
+                if(threadID == 0)
+                    A_.frontSizeHistogram(std::count(isCurrentNode.begin() + shiftN, isCurrentNode.begin() + shiftN + N_, true));
+                backend::barrier();
             #endif
-            #pragma omp for schedule(dynamic, 256)
-            for(size_t i = 0; i < N_; ++i){
+            frontier.forEach([&](std::size_t i) {
                 int idx = shift * N_ + i;
                 if(!isCurrentNode[idx])
-                    continue;
+                    return;
                 
                 A_.incrementProcessedNodes(threadID);
+                ++levelnodes;
 
                 auto parent = nodes_[i];
 
@@ -56,31 +64,41 @@ void Graph::topSort() {
 
 				auto childcount = parent->getChildCount();
                 A_.incrementProcessedEdges(threadID, childcount);
+				A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
 				for(unsigned c=0; c<childcount; ++c) {
 					auto child = parent->getChild(c);
 
 					// Checking if last parent trying to update
-                    A_.starttiming(analysis::REQUESTVALUEUPDATE);
                     auto flag = child->requestValueUpdate(); // This call is thread-safe
-                    A_.stoptiming(threadID, analysis::REQUESTVALUEUPDATE);
                     if(flag) { // last parent checking child
                         newChildrenPerThread[threadID] = true;
                         isCurrentNode[((shift+1)%2) * N_ + child->getID()] = true;// mark child as queued
 					} 
 				}
-			}// end for => one frontier completed       
-            A_.starttiming(analysis::SOLUTIONPUSHBACK);
-            #pragma omp critical
+				A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
+			});// end for => one frontier completed       
+            A_.tracer_.event(threadID, tracer::LEVELEND, level, levelnodes);
+            A_.tracer_.event(threadID, tracer::BARRIERBEGIN);
+            backend::barrier(); // end of the level
+            A_.tracer_.event(threadID, tracer::BARRIEREND);
+            A_.tracer_.event(threadID, tracer::CRITICALBEGIN);
+            A_.starttiming(threadID,analysis::SOLUTIONPUSHBACK);
             {
+                std::lock_guard<std::mutex> lock(solutionMutex);
                 solution_.splice(solution_.end(),solution_local);
             }
             A_.stoptiming(threadID, analysis::SOLUTIONPUSHBACK);            
-			#pragma omp single
+            A_.tracer_.event(threadID, tracer::CRITICALEND);
+			if(threadID == 0)
             {
+                ++level;
                 shift = (shift+1)%2;
                 char testval = true;
-                newChildren = std::find(newChildrenPerThread.begin(), newChildrenPerThread.end(), testval) != newChildrenPerThread.end();
+                newChildren = std::find(newChildrenPerThread.begin(), newChildrenPerThread.begin() + team, testval) != newChildrenPerThread.begin() + team;
+                frontier.reset();
             }
+            backend::barrier();
         }
-	} // end of OMP parallel
+		A_.stopthreadcounters(threadID);
+	}); // end of parallel team
 }
@@ -1,7 +1,10 @@
 #include <omp.h>
+#include <mutex>
 
 #include "graph.hpp"
 #include "analysis.hpp"
+#include "prefetch.hpp"
+#include "backend.hpp"
 
 std::string Graph::getName(){
     return "dynamic_nobarrier";
@@ -10,63 +13,75 @@ std::string Graph::getName(){
 void Graph::topSort() {
 	// Sorting Magic happens here
 	
-    int nThreads;
-    #pragma omp parallel
-    {
-        nThreads = omp_get_num_threads();
-    } 
+    const int chunk = getChunkSize(1024);
+    A_.setParameter("chunk", chunk);
+    A_.setParameter("threadPool", backend::threadPool);
+    const std::size_t distance = prefetch::distance();
+    A_.setParameter("prefetchDistance", distance);
     // Indicator vector true if node is a current node (aka frontier node)
     std::vector<char> isCurrentNode(N_, false); //std::vector<bool> is not thread-safe
-	// Spawn OMP threads
-	#pragma omp parallel
+    A_.recordMemory("frontier", isCurrentNode.capacity());
+    backend::dynamicLoop roots(N_, chunk);
+    std::mutex solutionMutex;
+	// Spawn threads (OpenMP team or thread pool, see backend.hpp)
+	backend::run([&](const int threadID, const int team)
 	{
 		// Declare Thread Private Variables
-		const int threadID = omp_get_thread_num();
 		type_nodelist currentnodes_local;
 		type_nodelist solution_local;
+		prefetch::listPipeline<type_nodelist> pipeline(distance);
+		auto far = [](const type_nodeptr& n) { return n->prefetchChildList(); };
+		auto near = [](const type_nodeptr& n) { return n->prefetchChildren(prefetch::fanoutLimit); };
+		A_.startthreadcounters(threadID);
 
 		// Distribute Root Nodes among Threads
-        #pragma omp for
-		for(unsigned i=0; i<N_; ++i) {
+		backend::staticFor(threadID, team, N_, [&](std::size_t i) {
 			if(nodes_[i]->getValue()==1)
                 isCurrentNode[i] = true;
-		}
+		});
+		backend::barrier();
             
-        #pragma omp for schedule(dynamic, 1024)
-        for(size_t i = 0; i < N_; ++i){
+        roots.forEach([&](std::size_t i) {
             if(!isCurrentNode[i])
-                continue;
+                return;
             
             // Each thread on its own
             currentnodes_local.push_back(nodes_[i]);
             while(!currentnodes_local.empty()) {
                 
                 A_.incrementProcessedNodes(threadID);
+                A_.incrementPrefetches(threadID, pipeline.advance(currentnodes_local, far, near));
                 
                 auto parent = currentnodes_local.front();
 
-                A_.starttiming(analysis::SOLUTIONPUSHBACK);
-                #pragma omp critical
-                solution_.push_back(parent); // put node in solution
+                A_.tracer_.event(threadID, tracer::CRITICALBEGIN);
+                A_.starttiming(threadID,analysis::SOLUTIONPUSHBACK);
+                {
+                    std::lock_guard<std::mutex> lock(solutionMutex);
+                    solution_.push_back(parent); // put node in solution
+                }
                 A_.stoptiming(threadID, analysis::SOLUTIONPUSHBACK);
+                A_.tracer_.event(threadID, tracer::CRITICALEND);
                 currentnodes_local.pop_front(); // remove current node - already visited
+                pipeline.pop();
 
                 auto childcount = parent->getChildCount();
                 A_.incrementProcessedEdges(threadID, childcount);
+                A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
                 for(type_size c=0; c<childcount; ++c) {
                     auto child = parent->getChild(c);
 
                     // Checking if last parent trying to update
-                    A_.starttiming(analysis::REQUESTVALUEUPDATE);
                     auto flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
-                    A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
                     
                     if(flag) { // last parent checking child
                         currentnodes_local.push_back(child); // add child node at end of queue
                     } 
             
                 }
+                A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
             }
-        }
-	} // end of OMP parallel
+        });
+		A_.stopthreadcounters(threadID);
+	}); // end of parallel team
 }
@@ -0,0 +1,135 @@
+#include <omp.h>
+#include <algorithm>
+#include <cstdlib>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+
+std::string Graph::getName(){
+    return "hybrid";
+}
+
+// Level-synchronous sort that sizes its team to the frontier of each level.
+// Levels with fewer than serialThreshold nodes are drained by the calling
+// thread alone, without any barrier, while the other threads stay parked in
+// the OpenMP pool. Wider levels are split into contiguous slices among
+// min(maxThreads, frontier/grain) threads, so threads join as the frontier
+// widens and leave again as it narrows.
+// Environment:	TOPOSORT_HYBRID_SERIAL	frontier size below which a level runs serially (default 4096)
+//				TOPOSORT_HYBRID_GRAIN	frontier nodes per thread of a parallel level (default 2048)
+void Graph::topSort() {
+
+	const type_size serialThreshold = getEnvSize("TOPOSORT_HYBRID_SERIAL", 4096);
+	const type_size grain = getEnvSize("TOPOSORT_HYBRID_GRAIN", 2048);
+	const int maxThreads = omp_get_max_threads();
+
+	type_nodearray currentnodes;
+	type_nodearray nextnodes;
+	for(type_size i=0; i<N_; ++i) {
+		if(nodes_[i]->getValue()==1) currentnodes.push_back(nodes_[i]);
+	}
+
+	std::vector<type_nodearray> nextnodes_local(maxThreads);
+	std::vector<type_nodelist> solution_local(maxThreads);
+	type_size level = 0;
+	type_size serialLevels = 0;
+	type_size parallelLevels = 0;
+	type_size threadLevels = 0; // sum of the team sizes of the parallel levels
+	int maxTeam = 1;
+
+	while(!currentnodes.empty()) {
+
+		++level;
+		const type_size nCurrentNodes = currentnodes.size();
+		A_.frontSizeHistogram(nCurrentNodes);
+		A_.tracer_.event(0,tracer::FRONTIER,level,nCurrentNodes);
+
+		const int nThreads = (nCurrentNodes < serialThreshold) ? 1
+			: std::max(1, std::min<int>(maxThreads, nCurrentNodes / grain));
+
+		if(nThreads == 1) {
+			// Serial level: no team, no barrier
+			++serialLevels;
+			A_.startthreadcounters(0);
+			A_.tracer_.event(0,tracer::LEVELBEGIN,level);
+			for(auto& parent : currentnodes) {
+				A_.incrementProcessedNodes(0);
+				solution_.push_back(parent);
+				const type_size childcount = parent->getChildCount();
+				A_.incrementProcessedEdges(0, childcount);
+				A_.starttiming(0,analysis::REQUESTVALUEUPDATE);
+				for(type_size c=0; c<childcount; ++c) {
+					auto child = parent->getChild(c);
+					bool flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
+					if(flag) nextnodes.push_back(child);
+				}
+				A_.stoptiming(0,analysis::REQUESTVALUEUPDATE);
+			}
+			A_.tracer_.event(0,tracer::LEVELEND,level,nCurrentNodes);
+			A_.stopthreadcounters(0);
+		} else {
+			// Parallel level: every thread takes a contiguous slice of the frontier
+			// The runtime may grant fewer threads than requested (OMP_DYNAMIC,
+			// OMP_THREAD_LIMIT): slice and join by the team that actually runs
+			int team = nThreads;
+			#pragma omp parallel num_threads(nThreads)
+			{
+				const int threadID = omp_get_thread_num();
+				const int nTeam = omp_get_num_threads();
+				#pragma omp master
+				team = nTeam;
+				const type_size begin = (static_cast<std::size_t>(nCurrentNodes) * threadID) / nTeam;
+				const type_size end = (static_cast<std::size_t>(nCurrentNodes) * (threadID+1)) / nTeam;
+				type_nodearray& next_local = nextnodes_local[threadID];
+				type_nodelist& sol_local = solution_local[threadID];
+
+				A_.startthreadcounters(threadID);
+				A_.tracer_.event(threadID,tracer::LEVELBEGIN,level);
+				for(type_size i=begin; i<end; ++i) {
+					A_.incrementProcessedNodes(threadID);
+					auto& parent = currentnodes[i];
+					sol_local.push_back(parent);
+					const type_size childcount = parent->getChildCount();
+					A_.incrementProcessedEdges(threadID, childcount);
+					A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
+					for(type_size c=0; c<childcount; ++c) {
+						auto child = parent->getChild(c);
+						bool flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
+						if(flag) next_local.push_back(child);
+					}
+					A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
+				}
+				A_.tracer_.event(threadID,tracer::LEVELEND,level,end-begin);
+				A_.stopthreadcounters(threadID);
+			} // end of OMP parallel
+			++parallelLevels;
+			threadLevels += team;
+			maxTeam = std::max(maxTeam, team);
+
+			// Join in thread order, the implicit barrier above already separates the levels
+			A_.starttiming(0,analysis::CURRENTGATHER);
+			for(int t=0; t<team; ++t) {
+				nextnodes.insert(nextnodes.end(), nextnodes_local[t].begin(), nextnodes_local[t].end());
+				nextnodes_local[t].clear();
+			}
+			A_.stoptiming(0,analysis::CURRENTGATHER);
+			A_.starttiming(0,analysis::SOLUTIONPUSHBACK);
+			for(int t=0; t<team; ++t) {
+				solution_.splice(solution_.end(), solution_local[t]);
+			}
+			A_.stoptiming(0,analysis::SOLUTIONPUSHBACK);
+		}
+
+		currentnodes.swap(nextnodes);
+		nextnodes.clear();
+	}
+
+	depth_ = level;
+
+	A_.setParameter("serialThreshold", serialThreshold);
+	A_.setParameter("grain", grain);
+	A_.setParameter("serialLevels", serialLevels);
+	A_.setParameter("parallelLevels", parallelLevels);
+	A_.setParameter("meanTeamSize", parallelLevels > 0 ? static_cast<double>(threadLevels) / parallelLevels : 1.);
+	A_.setParameter("maxTeamSize", maxTeam);
+}
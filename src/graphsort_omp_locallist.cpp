@@ -3,6 +3,8 @@
 
 #include "graph.hpp"
 #include "analysis.hpp"
+#include "prefetch.hpp"
+#include "barrier.hpp"
 
 using type_threadcount = analysis::type_time;
 
@@ -82,6 +84,7 @@ void Graph::topSort() {
 	// SHARED VARIABLES
 	type_size syncVal = 0;
 	type_size nCurrentNodes = 0;
+	type_size maxCurrentNodes = 0;
 	type_nodelist currentnodes;
 
 	// Start: currentnodes = root nodes 
@@ -89,6 +92,12 @@ void Graph::topSort() {
 		if(nodes_[i]->getValue()==1) currentnodes.push_back(nodes_[i]);
 	}
 	nCurrentNodes = currentnodes.size();
+	const std::size_t distance = prefetch::distance();
+	A_.setParameter("prefetchDistance", distance);
+	// TOPOSORT_BARRIER=spin: one user-space barrier per level, it also sums up the next frontier
+	const bool useSpin = spin::enabled();
+	A_.setParameter("spinBarrier", useSpin);
+	spin::barrier levelBarrier;
 	
 	// Spawn OMP threads
 	#pragma omp parallel shared(syncVal, nCurrentNodes, currentnodes)
@@ -99,67 +108,103 @@ void Graph::topSort() {
 		const int threadID = omp_get_thread_num();
 		type_nodelist currentnodes_local;
 		type_nodelist solution_local;
+		prefetch::listPipeline<type_nodelist> pipeline(distance);
+		auto far = [](const type_nodeptr& n) { return n->prefetchChildList(); };
+		auto near = [](const type_nodeptr& n) { return n->prefetchChildren(prefetch::fanoutLimit); };
 		
 		type_nodeptr parent;
 		type_nodeptr child;
 		type_size childcount = 0;
 		type_size currentvalue = 0;
+		type_size levelnodes = 0;
+		type_size sync = 0; // syncVal of this thread
+		type_size levelsize = nCurrentNodes; // nodes in currentnodes at the start of the level
 
 		A_.initialnodes(threadID,currentnodes_local.size());
+		A_.startthreadcounters(threadID);
 		
-		A_.starttiming(analysis::BARRIER);
+		#pragma omp single
+		levelBarrier.reset(omp_get_num_threads());
+
+		A_.starttiming(threadID,analysis::BARRIER);
 		#pragma omp barrier // make sure everything is set up alright
 		A_.stoptiming(threadID,analysis::BARRIER);
 		
-		while(!currentnodes.empty()) {
-
-			#pragma omp single
-			++syncVal;
-
-			#if VERBOSE>=2
-			#pragma omp single
-			std::cout << "\nCurrent syncVal = " << syncVal;
-			#endif // VERBOSE>=2
-			
-			#pragma omp single
-			{
-				nCurrentNodes = currentnodes.size();
-                A_.frontSizeHistogram(nCurrentNodes);
+		while(useSpin ? levelsize > 0 : !currentnodes.empty()) {
+
+			if(useSpin) {
+				// every thread got the frontier size from the last barrier
+				++sync;
+				if(threadID == 0) {
+					syncVal = sync;
+					maxCurrentNodes = std::max(maxCurrentNodes, levelsize);
+					A_.frontSizeHistogram(levelsize);
+					A_.tracer_.event(threadID,tracer::FRONTIER,syncVal,levelsize);
+				}
+			} else {
+				#pragma omp single
+				++syncVal;
+
+				#if VERBOSE>=2
+				#pragma omp single
+				std::cout << "\nCurrent syncVal = " << syncVal;
+				#endif // VERBOSE>=2
+				
+				#pragma omp single
+				{
+					nCurrentNodes = currentnodes.size();
+					maxCurrentNodes = std::max(maxCurrentNodes, nCurrentNodes);
+					A_.frontSizeHistogram(nCurrentNodes);
+					A_.tracer_.event(threadID,tracer::FRONTIER,syncVal,nCurrentNodes);
+				}
+				A_.tracer_.event(threadID,tracer::BARRIERBEGIN);
+				A_.starttiming(threadID,analysis::BARRIER);
+				#pragma omp barrier // make sure that nCurrentNodes is set
+				A_.stoptiming(threadID,analysis::BARRIER);
+				A_.tracer_.event(threadID,tracer::BARRIEREND);
+				sync = syncVal;
+				levelsize = nCurrentNodes;
 			}
-			A_.starttiming(analysis::BARRIER);
-			#pragma omp barrier // make sure that nCurrentNodes is set
-			A_.stoptiming(threadID,analysis::BARRIER);
+
+			A_.tracer_.event(threadID,tracer::LEVELBEGIN,syncVal);
+			levelnodes = 0;
 		
-			A_.starttiming(analysis::CURRENTSCATTER);
-			scatterlist(currentnodes,currentnodes_local,roundupdiv(nCurrentNodes,nThreads), threadID);
+			A_.tracer_.event(threadID,tracer::CRITICALBEGIN);
+			A_.starttiming(threadID,analysis::CURRENTSCATTER);
+			scatterlist(currentnodes,currentnodes_local,roundupdiv(levelsize,nThreads), threadID);
 			A_.stoptiming(threadID,analysis::CURRENTSCATTER);
+			A_.tracer_.event(threadID,tracer::CRITICALEND);
+			// change of currentnodes by this thread, the nodes of the next level may be taken and returned
+			spin::barrier::type_value delta = -static_cast<spin::barrier::type_value>(currentnodes_local.size());
 
 			while(!currentnodes_local.empty()) {
 				
 				A_.incrementProcessedNodes(threadID);
+				A_.incrementPrefetches(threadID, pipeline.advance(currentnodes_local, far, near));
 				
 				parent = currentnodes_local.front();
 				currentvalue = parent->getValue();
 
-				if(currentvalue>syncVal) {
-					assert(currentvalue == syncVal+1);
+				if(currentvalue>sync) {
+					assert(currentvalue == sync+1);
 					break;
 				} else {
 					solution_local.push_back(parent); // put node in solution
 					currentnodes_local.pop_front(); // remove current node - already visited
+					pipeline.pop();
+					++levelnodes;
 				}
 
 				++currentvalue; // increase value for child nodes
 				childcount = parent->getChildCount();
                 A_.incrementProcessedEdges(threadID, childcount);
 				bool flag;
+				A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
 				for(type_size c=0; c<childcount; ++c) {
 					child = parent->getChild(c);
 
 					// Checking if last parent trying to update
-					A_.starttiming(analysis::REQUESTVALUEUPDATE);
 					flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
-					A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
 					
 					if(flag) { // last parent checking child
 						currentnodes_local.push_back(child); // add child node at end of queue
@@ -167,24 +212,40 @@ void Graph::topSort() {
 					} 
 			
 				}
+				A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
 			}
 
+			A_.tracer_.event(threadID,tracer::LEVELEND,syncVal,levelnodes);
+
 			// Collect local lists in global list
-			A_.starttiming(analysis::CURRENTGATHER);
+			A_.tracer_.event(threadID,tracer::CRITICALBEGIN);
+			A_.starttiming(threadID,analysis::CURRENTGATHER);
+			delta += currentnodes_local.size();
 			gatherlist(currentnodes,currentnodes_local,threadID);
+			pipeline.reset(); // the nodes of the next level went to the global list
 			A_.stoptiming(threadID,analysis::CURRENTGATHER);
-			A_.starttiming(analysis::SOLUTIONPUSHBACK);
+			A_.starttiming(threadID,analysis::SOLUTIONPUSHBACK);
 			gatherlist(solution_,solution_local,threadID);
 			A_.stoptiming(threadID,analysis::SOLUTIONPUSHBACK);
+			A_.tracer_.event(threadID,tracer::CRITICALEND);
 			
-			A_.starttiming(analysis::BARRIER);
-			#pragma omp barrier
+			A_.tracer_.event(threadID,tracer::BARRIERBEGIN);
+			A_.starttiming(threadID,analysis::BARRIER);
+			if(useSpin) {
+				levelsize += levelBarrier.sum(threadID, delta);
+			} else {
+				#pragma omp barrier
+			}
 			A_.stoptiming(threadID,analysis::BARRIER);
+			A_.tracer_.event(threadID,tracer::BARRIEREND);
 			
 		}
+
+		A_.stopthreadcounters(threadID);
 	
 	} // end of OMP parallel
 
 	depth_ = syncVal;
+	A_.recordMemory("frontier", maxCurrentNodes * listNodeBytes);
 
 }
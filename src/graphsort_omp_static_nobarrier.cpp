@@ -0,0 +1,79 @@
+#include <omp.h>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "prefetch.hpp"
+
+std::string Graph::getName(){
+    return "static_nobarrier";
+}
+
+void Graph::topSort() {
+	// Sorting Magic happens here
+
+    const std::size_t distance = prefetch::distance();
+    A_.setParameter("prefetchDistance", distance);
+    // Indicator vector true if node is a current node (aka frontier node)
+    std::vector<char> isCurrentNode(N_, false); //std::vector<bool> is not thread-safe
+    A_.recordMemory("frontier", isCurrentNode.capacity());
+	// Spawn OMP threads
+	#pragma omp parallel
+	{
+		// Declare Thread Private Variables
+		const int threadID = omp_get_thread_num();
+		type_nodelist currentnodes_local;
+		prefetch::listPipeline<type_nodelist> pipeline(distance);
+		auto far = [](const type_nodeptr& n) { return n->prefetchChildList(); };
+		auto near = [](const type_nodeptr& n) { return n->prefetchChildren(prefetch::fanoutLimit); };
+		A_.startthreadcounters(threadID);
+
+		// Distribute Root Nodes among Threads
+        #pragma omp for
+		for(unsigned i=0; i<N_; ++i) {
+			if(nodes_[i]->getValue()==1)
+                isCurrentNode[i] = true;
+		}
+            
+        #pragma omp for schedule(static)
+        for(size_t i = 0; i < N_; ++i){
+            if(!isCurrentNode[i])
+                continue;
+            
+            // Each thread on its own
+            currentnodes_local.push_back(nodes_[i]);
+            while(!currentnodes_local.empty()) {
+                
+                A_.incrementProcessedNodes(threadID);
+                A_.incrementPrefetches(threadID, pipeline.advance(currentnodes_local, far, near));
+                
+                auto parent = currentnodes_local.front();
+
+                A_.tracer_.event(threadID, tracer::CRITICALBEGIN);
+                A_.starttiming(threadID,analysis::SOLUTIONPUSHBACK);
+                #pragma omp critical
+                solution_.push_back(parent); // put node in solution
+                A_.stoptiming(threadID, analysis::SOLUTIONPUSHBACK);
+                A_.tracer_.event(threadID, tracer::CRITICALEND);
+                currentnodes_local.pop_front(); // remove current node - already visited
+                pipeline.pop();
+
+                auto childcount = parent->getChildCount();
+                A_.incrementProcessedEdges(threadID, childcount);
+                A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
+                for(type_size c=0; c<childcount; ++c) {
+                    auto child = parent->getChild(c);
+
+                    // Checking if last parent trying to update
+                    auto flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
+                    
+                    if(flag) { // last parent checking child
+                        currentnodes_local.push_back(child); // add child node at end of queue
+                    } 
+            
+                }
+                A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
+            }
+        }
+		A_.stopthreadcounters(threadID);
+	} // end of OMP parallel
+}
@@ -0,0 +1,143 @@
+#include <omp.h>
+#include <algorithm>
+#include <utility>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+
+std::string Graph::getName(){
+    return "tasks";
+}
+
+namespace mytasks {
+
+	// Shared state of all tasks. Sorted nodes are written to a preallocated
+	// array through an atomic position counter, so the solution needs no lock.
+	class taskSorter {
+
+		public:
+
+			taskSorter(Graph::type_size N, analysis& A, Graph::type_size spawnCutoff, Graph::type_size batchCutoff)
+				: order_(N)
+				, pos_(0)
+				, A_(A)
+				, spawnCutoff_(spawnCutoff)
+				, batchCutoff_(batchCutoff)
+			{}
+
+			// Processes the nodes of ready and every node that becomes ready on the
+			// way. A ready node with at least spawnCutoff_ children gets its own
+			// task, smaller ones are processed inline. Once batchCutoff_ inline nodes
+			// are pending, half of them are handed to a new task.
+			// PRE:		all nodes of ready have in-degree zero, called inside a taskgroup
+			void drain(Graph::type_nodearray ready) {
+				const int threadID = omp_get_thread_num();
+				while(!ready.empty()) {
+					Graph::type_nodeptr parent = ready.back();
+					ready.pop_back();
+
+					A_.incrementProcessedNodes(threadID);
+					A_.starttiming(threadID,analysis::SOLUTIONPUSHBACK);
+					order_[__sync_fetch_and_add(&pos_, 1)] = parent;
+					A_.stoptiming(threadID,analysis::SOLUTIONPUSHBACK);
+
+					const Graph::type_size childcount = parent->getChildCount();
+					A_.incrementProcessedEdges(threadID, childcount);
+					A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
+					for(Graph::type_size c=0; c<childcount; ++c) {
+						Graph::type_nodeptr child = parent->getChild(c);
+
+						bool flag = child->requestValueUpdate(); // IMPORTANT: control atomicity using OPTIMISTIC flag
+						if(!flag) continue;
+
+						if(child->getChildCount() >= spawnCutoff_) {
+							// the runtime may run the task right here, it times itself
+							A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
+							#pragma omp task firstprivate(child)
+							drain(Graph::type_nodearray(1, child));
+							A_.starttiming(threadID,analysis::REQUESTVALUEUPDATE);
+						} else {
+							ready.push_back(child);
+						}
+					}
+					A_.stoptiming(threadID,analysis::REQUESTVALUEUPDATE);
+
+					if(ready.size() >= batchCutoff_) {
+						Graph::type_nodearray batch(ready.begin() + ready.size()/2, ready.end());
+						ready.resize(ready.size()/2);
+						#pragma omp task firstprivate(batch)
+						drain(std::move(batch));
+					}
+				}
+			}
+
+			// POST:	returns the sorted nodes, valid once the taskgroup has finished
+			inline Graph::type_nodearray& order() {
+				return order_;
+			}
+
+			inline Graph::type_size count() const {
+				return pos_;
+			}
+
+		private:
+
+			Graph::type_nodearray order_;
+			Graph::type_size pos_;
+			analysis& A_;
+			const Graph::type_size spawnCutoff_;
+			const Graph::type_size batchCutoff_;
+	};
+
+} // end namespace mytasks
+
+
+// Fully asynchronous sort: a node is processed as soon as its in-degree
+// reaches zero, there are no levels and no barriers. Termination is the end
+// of the taskgroup, load balance is left to the OpenMP task scheduler.
+// Environment:	TOPOSORT_TASK_SPAWN	ready nodes with at least this many children get their own task (default 32)
+//				TOPOSORT_TASK_BATCH	pending inline nodes at which half of them move to a new task (default 256)
+void Graph::topSort() {
+
+	const type_size spawnCutoff = getEnvSize("TOPOSORT_TASK_SPAWN", 32);
+	const type_size batchCutoff = std::max<type_size>(2, getEnvSize("TOPOSORT_TASK_BATCH", 256));
+	A_.setParameter("spawnCutoff", spawnCutoff);
+	A_.setParameter("batchCutoff", batchCutoff);
+
+	mytasks::taskSorter sorter(N_, A_, spawnCutoff, batchCutoff);
+
+	#pragma omp parallel
+	{
+		const int threadID = omp_get_thread_num();
+		A_.startthreadcounters(threadID);
+
+		#pragma omp single
+		{
+			#pragma omp taskgroup
+			{
+				// Root nodes are handed out in batches of batchCutoff
+				type_nodearray roots;
+				for(type_size i=0; i<N_; ++i) {
+					if(nodes_[i]->getValue()!=1) continue;
+					roots.push_back(nodes_[i]);
+					if(roots.size() == batchCutoff) {
+						#pragma omp task firstprivate(roots)
+						sorter.drain(std::move(roots));
+						roots.clear();
+					}
+				}
+				if(!roots.empty()) {
+					#pragma omp task firstprivate(roots)
+					sorter.drain(std::move(roots));
+				}
+			} // end of taskgroup: every task, including descendants, has finished
+		}
+
+		A_.stopthreadcounters(threadID);
+	} // end of OMP parallel
+
+	type_nodearray& order = sorter.order();
+	for(type_size i=0; i<sorter.count(); ++i) {
+		solution_.push_back(order[i]);
+	}
+}
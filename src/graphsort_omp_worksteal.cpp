@@ -1,9 +1,11 @@
 #include <omp.h>
 #include <algorithm>
 #include <cstdlib>
+#include <numeric>
 
 #include "graph.hpp"
 #include "analysis.hpp"
+#include "barrier.hpp"
 
 using type_threadcount = analysis::type_threadcount;
 
@@ -162,13 +164,16 @@ namespace myworksteal {
 		public:
 		
 			// PRE: must call constructor single threaded
-			nodePool(Graph::type_size nThreads, Graph::type_nodelist& sollist, analysis& A)
-				: nThreads_(nThreads)
+			// useSpin: one spin::barrier per level instead of the #pragma omp barrier steps
+			nodePool(Graph::type_size nThreads, Graph::type_nodelist& sollist, analysis& A, bool useSpin)
+				: A_(A)
+				, nThreads_(nThreads)
 				, globalsolution_(sollist)
-				, A_(A)
 				, nDoneWithSyncVal_(0)
 				, doneWithSyncVal_(nThreads_,0)
 				, nodelists_(nThreads_,myworksteal::threadLocallist(*this))
+				, useSpin_(useSpin)
+				, levelBarrier_()
 			{
 				#if VERBOSE>0
 					std::cout << "\n\nInitialized thread-locallists for " << nThreads_ << " threads:\n\n";
@@ -239,6 +244,7 @@ namespace myworksteal {
 				// SHARED VARIABLES
 				Graph::type_size syncVal = 1;
 				bool notdone = true;
+				levelBarrier_.reset(nThreads_);
 
 				// Spawn OMP threads
 				#pragma omp parallel shared(syncVal,notdone)
@@ -251,38 +257,67 @@ namespace myworksteal {
 
 					// THREAD PRIVATE VARIABLES
 					const int threadID = omp_get_thread_num();
+					Graph::type_size sync = 1; // syncVal of this thread
+					bool more = true; // notdone of this thread
+					A_.startthreadcounters(threadID);
 		
 					#pragma omp barrier
 
 					do {
 
+						if(useSpin_) {
+							// the last barrier of the previous level: nobody reads the flag any more
+							doneWithSyncVal_[threadID] = 0;
+						} else {
+							sync = syncVal;
+						}
 						#pragma omp critical 
-						nodelists_[threadID].nextSyncVal(syncVal);
-						#pragma omp barrier
+						nodelists_[threadID].nextSyncVal(sync);
+						A_.tracer_.event(threadID,tracer::BARRIERBEGIN);
+						if(useSpin_) {
+							levelBarrier_.wait(threadID);
+						} else {
+							#pragma omp barrier
+						}
+						A_.tracer_.event(threadID,tracer::BARRIEREND);
 						
 						#if VERBOSE>0
-							#pragma omp single
-							std::cout << "\nCurrent syncVal = " << syncVal;
+							if(threadID == 0) std::cout << "\nCurrent syncVal = " << sync;
 						#endif // VERBOSE>0
 	
 						nodelists_[threadID].work(threadID);
-						#pragma omp barrier
+						A_.tracer_.event(threadID,tracer::BARRIERBEGIN);
+						if(useSpin_) {
+							// ends the level and counts the threads that hold nodes of the next one
+							more = levelBarrier_.sum(threadID, nodelists_[threadID].noMoreNodes() ? 0 : 1) > 0;
+							A_.tracer_.event(threadID,tracer::BARRIEREND);
+							++sync;
+							if(threadID == 0) syncVal = sync;
+						} else {
+							#pragma omp barrier
+							A_.tracer_.event(threadID,tracer::BARRIEREND);
 
-						#pragma omp single
-						notdone = !sortingComplete();
-						
-						#pragma omp single nowait
-						setUndoneAll();
-						
-						#pragma omp single nowait
-						++syncVal;
+							#pragma omp single
+							notdone = !sortingComplete();
+							
+							#pragma omp single nowait
+							setUndoneAll();
+							
+							#pragma omp single nowait
+							++syncVal;
+
+							more = notdone;
+						}
 
-					} while(notdone);
+					} while(more);
+
+					A_.stopthreadcounters(threadID);
 				
 				} // end of OMP parallel
 				#pragma omp single
 				graph.setDepth(syncVal);
 
+				return globalsolution_;
 			}
 
 			inline Graph::type_nodeptr tryStealFrom(type_threadcount tid) {
@@ -297,6 +332,8 @@ namespace myworksteal {
 			type_threadcount nDoneWithSyncVal_;
 			std::vector<type_threadcount> doneWithSyncVal_;
 			std::vector<myworksteal::threadLocallist> nodelists_;
+			const bool useSpin_;
+			spin::barrier levelBarrier_;
 
 		friend std::ostream& operator<<(std::ostream&, nodePool&);
 		friend class threadLocallist;
@@ -308,6 +345,7 @@ namespace myworksteal {
 			std::cout << "\n\nCurrent state of ThreadPool:\n";
 			std::cout << ndp.nodelists_[i];
 		}
+		return os;
 	}
 	#endif // DEBUG>0 || VERBOSE>0
 
@@ -326,8 +364,14 @@ namespace myworksteal {
 		Graph::type_nodeptr parent;
 		Graph::type_nodeptr child;
 		Graph::type_size childcount = 0;
+		Graph::type_size levelnodes = 0;
 
-		#pragma omp barrier // make sure everything is set up alright
+		if(!np_.useSpin_) { // the spin barrier in workparallel just passed
+			np_.A_.tracer_.event(tid_,tracer::BARRIERBEGIN);
+			#pragma omp barrier // make sure everything is set up alright
+			np_.A_.tracer_.event(tid_,tracer::BARRIEREND);
+		}
+		np_.A_.tracer_.event(tid_,tracer::LEVELBEGIN,currentSyncVal_);
 	
 
 		Graph::type_size currentvalue;
@@ -359,9 +403,12 @@ namespace myworksteal {
 					}
                     np_.A_.incrementProcessedEdges(tid_, childcount);
 					np_.A_.incrementProcessedNodes(tid_);
+					++levelnodes;
 
 				}
+				np_.A_.tracer_.event(tid_,tracer::CRITICALBEGIN);
 				stackToFast();
+				np_.A_.tracer_.event(tid_,tracer::CRITICALEND);
 			}
 	
 			np_.doneWithStack(tid_);
@@ -371,8 +418,10 @@ namespace myworksteal {
 				break;
 			} else { // steal work while others are still busy 
 				analysis::type_threadcount stealindex = rand()%np_.getNThreads();
+				np_.A_.tracer_.event(tid_,tracer::STEALATTEMPT,currentSyncVal_,stealindex);
 				Graph::type_nodeptr newnode = np_.tryStealFrom(stealindex);
 				if(newnode!=nullptr) {
+					np_.A_.tracer_.event(tid_,tracer::STEALSUCCESS,currentSyncVal_,stealindex);
 					locallist_current_fast_.push_back(newnode);
 				}
 			}
@@ -380,11 +429,18 @@ namespace myworksteal {
 		} while(!np_.allDoneWithSyncVal());
 
 		np_.doneWithSyncVal(tid_);
+		np_.A_.tracer_.event(tid_,tracer::LEVELEND,currentSyncVal_,levelnodes);
 
-		#pragma omp barrier
+		if(!np_.useSpin_) { // else the level ends with the spin barrier in workparallel
+			np_.A_.tracer_.event(tid_,tracer::BARRIERBEGIN);
+			#pragma omp barrier
+			np_.A_.tracer_.event(tid_,tracer::BARRIEREND);
+		}
 
 		// Collect local lists in global list
+		np_.A_.tracer_.event(tid_,tracer::CRITICALBEGIN);
 		gatherlist(np_.globalsolution_,solution_local_,tid_);
+		np_.A_.tracer_.event(tid_,tracer::CRITICALEND);
 
 	}
 
@@ -394,7 +450,10 @@ namespace myworksteal {
 
 void Graph::topSort() {
 
-	myworksteal::nodePool nodepool(this->A_.nThreads_,this->solution_,A_);
+	// TOPOSORT_BARRIER=spin: two user-space barriers per level instead of five OpenMP ones
+	const bool useSpin = spin::enabled();
+	A_.setParameter("spinBarrier", useSpin);
+	myworksteal::nodePool nodepool(this->A_.nThreads_,this->solution_,A_,useSpin);
 
 	// Sorting Magic happens here
 
@@ -2,6 +2,7 @@
 
 #include "graph.hpp"
 #include "analysis.hpp"
+#include "prefetch.hpp"
 
 std::string Graph::getName(){
     return "serial";
@@ -9,8 +10,15 @@ std::string Graph::getName(){
 
 void Graph::topSort() {
 	
+	A_.startthreadcounters(0);
+	const std::size_t distance = prefetch::distance();
+	A_.setParameter("prefetchDistance", distance);
+
 	// Sorting Magic happens here
 	std::list<std::shared_ptr<Node> > currentnodes;
+	prefetch::listPipeline<type_nodelist> pipeline(distance);
+	auto far = [](const type_nodeptr& n) { return n->prefetchChildList(); };
+	auto near = [](const type_nodeptr& n) { return n->prefetchChildren(prefetch::fanoutLimit); };
 	
 	std::shared_ptr<Node> parent;
 	std::shared_ptr<Node> child;
@@ -24,11 +32,13 @@ void Graph::topSort() {
 
 	while(!currentnodes.empty()) {
 
+		A_.incrementPrefetches(0, pipeline.advance(currentnodes, far, near));
 		parent = currentnodes.front();
 		currentvalue = parent->getValue();
 
 		solution_.push_back(parent); // IMPORTANT: this must be atomic
 		currentnodes.pop_front(); // remove current node - already visited
+		pipeline.pop();
 
 		++currentvalue; // increase value for child nodes
 		childcount = parent->getChildCount();
@@ -48,4 +58,6 @@ void Graph::topSort() {
 		}
 	}
 
+	A_.stopthreadcounters(0);
+
 }
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "toposort.h"
+
+// Checks of libtoposort.so (toposort.h) on small hand-made graphs: every
+// engine must return a valid order on the acyclic ones and TOPOSORT_ECYCLE,
+// without crashing, on the cyclic ones. Returns the number of failed checks.
+
+struct testGraph {
+	std::string name;
+	uint32_t n;
+	std::vector<std::pair<uint32_t,uint32_t> > edges;
+	bool acyclic;
+};
+
+// POST:	CSR arrays of the edge list of g, offsets has n+1 entries
+static void toCSR(const testGraph& g, std::vector<uint64_t>& offsets, std::vector<uint32_t>& targets) {
+	offsets.assign(g.n + 1, 0);
+	for(const auto& e : g.edges) ++offsets[e.first + 1];
+	for(uint32_t v = 0; v < g.n; ++v) offsets[v + 1] += offsets[v];
+	targets.assign(g.edges.size(), 0);
+	std::vector<uint64_t> pos(offsets.begin(), offsets.end() - 1);
+	for(const auto& e : g.edges) targets[pos[e.first]++] = e.second;
+}
+
+// POST:	true if order is a permutation of 0..n-1 in which every edge points forward
+//			and the level of every child is above the level of its parent
+static bool validOrder(const testGraph& g, const std::vector<uint32_t>& order, const std::vector<uint32_t>& levels) {
+	std::vector<uint32_t> position(g.n, g.n);
+	for(uint32_t i = 0; i < g.n; ++i) {
+		if(order[i] >= g.n || position[order[i]] != g.n) return false;
+		position[order[i]] = i;
+	}
+	for(const auto& e : g.edges) {
+		if(position[e.first] > position[e.second] || levels[e.first] >= levels[e.second]) return false;
+	}
+	return true;
+}
+
+// POST:	true if engine handles g as expected, the outcome is printed
+template <typename Index>
+static bool check(const testGraph& g, const char* engine) {
+	std::vector<uint64_t> offsets;
+	std::vector<uint32_t> targets32;
+	toCSR(g, offsets, targets32);
+	const std::vector<Index> targets(targets32.begin(), targets32.end());
+	std::vector<Index> order(g.n), levels(g.n);
+	toposort_stats stats;
+	toposort_status status;
+	if(sizeof(Index) == sizeof(uint32_t)) {
+		status = toposort_sort_stats(g.n, offsets.data(), reinterpret_cast<const uint32_t*>(targets.data()), engine, 0, 1,
+			reinterpret_cast<uint32_t*>(order.data()), reinterpret_cast<uint32_t*>(levels.data()), &stats);
+	} else {
+		status = toposort_sort64_stats(g.n, offsets.data(), reinterpret_cast<const uint64_t*>(targets.data()), engine, 0, 1,
+			reinterpret_cast<uint64_t*>(order.data()), reinterpret_cast<uint64_t*>(levels.data()), &stats);
+	}
+
+	bool ok;
+	if(g.acyclic) {
+		ok = status == TOPOSORT_OK
+			&& validOrder(g, std::vector<uint32_t>(order.begin(), order.end()), std::vector<uint32_t>(levels.begin(), levels.end()));
+	} else {
+		ok = status == TOPOSORT_ECYCLE && stats.nodes < g.n;
+	}
+	std::cout << (ok ? "\033[1;32mOK\033[0m   " : "\033[1;31mFAIL\033[0m ") << engine << (sizeof(Index) == 8 ? "/64" : "") << "\t" << g.name
+	          << ":\t" << toposort_strerror(status) << ", " << stats.nodes << " of " << g.n << " nodes ordered\n";
+	return ok;
+}
+
+int main() {
+	const std::vector<testGraph> graphs = {
+		{"chain",			5, {{0,1},{1,2},{2,3},{3,4}}, true},
+		{"diamond",			4, {{0,1},{0,2},{1,3},{2,3}}, true},
+		{"ring",			3, {{0,1},{1,2},{2,0}}, false},	// links only, no chain has a head
+		{"ring + edge",		5, {{0,1},{1,2},{2,0},{3,4}}, false},
+		{"self-loop",		2, {{0,1},{1,1}}, false},
+		{"cycle below a root",	6, {{0,1},{0,4},{1,2},{2,3},{3,1},{4,5}}, false},
+		{"two components, one cyclic",	6, {{0,1},{1,2},{3,4},{4,5},{5,4}}, false},
+	};
+	const std::vector<const char*> engines = {"serial", "levels", "chains", "components"};
+	const std::vector<const char*> engines64 = {"serial", "levels"};
+
+	int failed = 0;
+	for(auto engine : engines) {
+		for(const auto& g : graphs) {
+			if(!check<uint32_t>(g, engine)) ++failed;
+		}
+	}
+	for(auto engine : engines64) {
+		for(const auto& g : graphs) {
+			if(!check<uint64_t>(g, engine)) ++failed;
+		}
+	}
+	std::cout << "\n" << failed << " checks failed\n";
+	return failed;
+}
@@ -0,0 +1,148 @@
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+#include "autotune.hpp"
+
+// Auto mode: profiles the graph, chooses engine, thread count and chunk size
+// and runs the chosen toposort_<engine>.exe with the same arguments. The
+// outcome of the run is appended to the tuning file, so later runs on graphs
+// with the same profile key pick the fastest configuration seen so far.
+// Environment:	TOPOSORT_TUNINGFILE		tuning file (default toposort_tuning.txt)
+//				TOPOSORT_AUTO_EXPLORE	if set, engines without a record for the profile are tried first
+
+// In-memory engines the auto mode may choose from
+static const char* candidates[] = {"serial", "omp_locallist", "omp_bitset", "omp_worksteal", "omp_dynamic_nobarrier", "omp_static_nobarrier", "omp_tasks", "omp_hybrid", "csr_levels", "csr_chains", "csr_components"};
+
+// POST:	returns the directory of the executable, including the trailing '/'
+static std::string exeDir(const std::string& argv0) {
+	std::size_t pos = argv0.find_last_of('/');
+	return pos == std::string::npos ? "./" : argv0.substr(0,pos+1);
+}
+
+// POST:	runs toposort_<c.engine_>.exe with args, returns false if it could not be started or failed
+static bool runEngine(const std::string& dir, const autotune::choice& c, const std::vector<std::string>& args, const std::string& resultFile) {
+	std::string exe = dir + "toposort_" + c.engine_ + ".exe";
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(exe.c_str()));
+	for(const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+	argv.push_back(nullptr);
+
+	std::cout.flush();
+	pid_t pid = fork();
+	if(pid < 0) {
+		std::cerr << "Could not start " << exe << std::endl;
+		return false;
+	}
+	if(pid == 0) {
+		setenv("OMP_NUM_THREADS", std::to_string(c.nThreads_).c_str(), 1);
+		if(c.chunk_ > 0) setenv("TOPOSORT_CHUNK", std::to_string(c.chunk_).c_str(), 1);
+		setenv("TOPOSORT_RESULTFILE", resultFile.c_str(), 1);
+		execv(exe.c_str(), argv.data());
+		std::cerr << "Could not execute " << exe << std::endl;
+		_exit(127);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char* argv[]) {
+	if(argc == 2 && std::string(argv[1]) == "--help"){
+		std::cout << "Usage: ./toposort_auto.exe [graphType = s [,N=5000 [,destDir=results [,edgeFillDegree = 2.7 [,p = 0.5, q = 0.7 [,nChains = 100]]]]]]" << std::endl;
+		std::cout << "Same arguments as toposort_xyz.exe, the engine is chosen from a profile of the graph" << std::endl;
+		return 0;
+	}
+	// Standard values, as in main_toposort.cpp
+	char graphType = 's';
+	unsigned N = 500000;
+	double edgeFillDegree = 2.7;
+	double p = 0.5;
+	double q = 0.7;
+	int nChains = 100;
+
+	if(argc >= 2) graphType = argv[1][0];
+	if(argc >= 3) N = std::stoi(argv[2]);
+	if(argc >= 5) edgeFillDegree = std::stod(argv[4]);
+	if(argc >= 6) p = std::stod(argv[5]);
+	if(argc >= 7) q = std::stod(argv[6]);
+	if(argc >= 8) nChains = std::stoi(argv[7]);
+	std::vector<std::string> args(argv+1, argv+argc);
+
+	const char* env_tuning = std::getenv("TOPOSORT_TUNINGFILE");
+	const std::string tuningFile = env_tuning ? env_tuning : "toposort_tuning.txt";
+	const bool explore = std::getenv("TOPOSORT_AUTO_EXPLORE") != nullptr;
+	const int maxThreads = omp_get_max_threads();
+	const std::string dir = exeDir(argv[0]);
+
+	std::vector<std::string> engines;
+	for(const char* e : candidates) {
+		if(access((dir + "toposort_" + e + ".exe").c_str(), X_OK) == 0)
+			engines.push_back(e);
+	}
+	if(engines.empty()) {
+		std::cerr << "No toposort_xyz.exe found in " << dir << std::endl;
+		return 1;
+	}
+
+	// Profile the graph, it is freed again before the engine builds its own copy
+	Graph::profile prof;
+	{
+		Graph graph(N);
+		switch(graphType) {
+			case 's': graph.connect(Graph::SOFTWARE, 0., p, q); break;
+			case 'r': graph.connect(Graph::RANDOM_LIN, edgeFillDegree); break;
+			case 'c': graph.connect(Graph::CHAIN); break;
+			case 'm': graph.connect(Graph::MULTICHAIN, 0., 0., 0., nChains); break;
+			default: // test graphs are too small to be worth a profile
+			{
+				autotune::choice c;
+				c.engine_ = engines.front();
+				return runEngine(dir, c, args, "/dev/null") ? 0 : 1;
+			}
+		}
+		prof = graph.getProfile();
+	}
+	const std::string key = autotune::profileKey(prof);
+
+	autotune::choice c = autotune::heuristic(prof, maxThreads, engines);
+	bool fromTuning = autotune::lookup(tuningFile, key, maxThreads, engines, explore, c);
+
+	std::cout << "\nauto: profile " << key << " (sources: " << prof.nSources_ << ", depth >= " << prof.depthEstimate_
+	          << ", width ~ " << prof.widthEstimate_ << ", children quantiles:";
+	for(auto qt : prof.childrenQuantiles_) std::cout << " " << qt;
+	std::cout << ")\nauto: running " << c.engine_ << " with " << c.nThreads_ << " threads, chunk " << c.chunk_
+	          << (fromTuning ? " (tuning file)" : " (heuristic)") << std::endl;
+
+	char resultFile[] = "/tmp/toposort_auto_XXXXXX";
+	int fd = mkstemp(resultFile);
+	if(fd < 0) {
+		std::cerr << "Could not create result file" << std::endl;
+		return 1;
+	}
+	close(fd);
+
+	bool ok = runEngine(dir, c, args, resultFile);
+	double seconds = 0.;
+	bool correct = false;
+	std::ifstream res(resultFile);
+	ok = ok && static_cast<bool>(res >> seconds >> correct) && correct;
+	res.close();
+	std::remove(resultFile);
+
+	if(!ok) {
+		std::cerr << "auto: " << c.engine_ << " failed, nothing recorded" << std::endl;
+		return 1;
+	}
+	autotune::record(tuningFile, key, c, seconds);
+	std::cout << "auto: " << c.engine_ << " took " << seconds << " sec, recorded in " << tuningFile << std::endl;
+	return 0;
+}
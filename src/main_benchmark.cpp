@@ -0,0 +1,151 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <sched.h>
+#include <omp.h>
+
+#include "graph.hpp"
+#include "analysis.hpp"
+
+// Benchmark harness: sweeps graph types x sizes x thread counts for the
+// algorithm this executable is linked with. Every repetition is inserted as
+// one row into the measurements database used by the plot scripts, the sweep
+// over algorithms is done by running all benchmark_*.exe (see "make bench").
+
+// PRE:		str is a comma separated list
+// POST:	returns the list elements
+static std::vector<std::string> splitList(const std::string& str) {
+	std::vector<std::string> items;
+	std::stringstream ss(str);
+	std::string item;
+	while(std::getline(ss,item,',')) {
+		if(!item.empty()) items.push_back(item);
+	}
+	return items;
+}
+
+// Pins thread i of a team of nThreads to processor i (round robin). The
+// OpenMP runtime keeps its threads alive between parallel regions, so the
+// affinity persists for the sorts that follow. Left alone if the user
+// controls binding through OMP_PROC_BIND or OMP_PLACES.
+static void pinThreads(int nThreads) {
+	if(std::getenv("OMP_PROC_BIND") || std::getenv("OMP_PLACES")) return;
+	const int nProcs = omp_get_num_procs();
+	#pragma omp parallel num_threads(nThreads)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(omp_get_thread_num() % nProcs, &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+}
+
+// Builds the graph exactly like main_toposort does for the same graph type
+static bool connectGraph(Graph& graph, char graphType, double edgeFillDegree, double p, double q, int nChains) {
+	switch(graphType) {
+		case 's': graph.connect(Graph::SOFTWARE, 0., p, q); return true;
+		case 'r': graph.connect(Graph::RANDOM_LIN, edgeFillDegree); return true;
+		case 'c': graph.connect(Graph::CHAIN); return true;
+		case 'm': graph.connect(Graph::MULTICHAIN, 0., 0., 0., nChains); return true;
+		default:
+			std::cout << "Unknown Graph Type " << graphType << std::endl;
+			return false;
+	}
+}
+
+// PRE:		sorted is sorted and not empty
+// POST:	returns the q-quantile (linear interpolation, as numpy.percentile)
+static double quantile(const std::vector<double>& sorted, double q) {
+	double pos = q * (sorted.size()-1);
+	std::size_t lo = static_cast<std::size_t>(pos);
+	std::size_t hi = std::min(lo+1, sorted.size()-1);
+	return sorted[lo] + (pos-lo) * (sorted[hi]-sorted[lo]);
+}
+
+int main(int argc, char* argv[]) {
+	if(argc == 2 && std::string(argv[1]) == "--help"){
+		std::cout << "Usage: ./benchmark_xyz.exe [dbFile=../measurements/measurements.db [,graphTypes=s [,sizes=100000 [,threads=max [,repetitions=10 [,warmup=1 [,edgeFillDegree=2.7 [,comment=benchmark]]]]]]]]" << std::endl;
+		std::cout << "graphTypes, sizes and threads are comma separated lists, e.g. s,r 100000,1000000 1,2,4,8; threads defaults to omp_get_max_threads()" << std::endl;
+		std::cout << "Graph Types: s: Software\tr: Random \tc: Chain\tm: Mulitchain" << std::endl;
+		return 0;
+	}
+	// Standard values
+	std::string dbFile = "../measurements/measurements.db";
+	std::string graphTypes = "s";
+	std::string sizes = "100000";
+	std::string threads = std::to_string(omp_get_max_threads());
+	int repetitions = 10;
+	int warmup = 1;
+	double edgeFillDegree = 2.7;
+	std::string comment = "benchmark";
+	const double p = 0.5;
+	const double q = 0.7;
+	const int nChains = 100;
+
+	// Read in command-line overrides
+	int cnt_arg = 1;
+	if(argc >= ++cnt_arg)
+		dbFile = argv[cnt_arg-1];
+	if(argc >= ++cnt_arg)
+		graphTypes = argv[cnt_arg-1];
+	if(argc >= ++cnt_arg)
+		sizes = argv[cnt_arg-1];
+	if(argc >= ++cnt_arg)
+		threads = argv[cnt_arg-1];
+	if(argc >= ++cnt_arg)
+		repetitions = std::stoi(argv[cnt_arg-1]);
+	if(argc >= ++cnt_arg)
+		warmup = std::stoi(argv[cnt_arg-1]);
+	if(argc >= ++cnt_arg)
+		edgeFillDegree = std::stod(argv[cnt_arg-1]);
+	if(argc >= ++cnt_arg)
+		comment = argv[cnt_arg-1];
+
+	std::stringstream summary;
+	summary << std::setprecision(6) << std::fixed;
+
+	for(auto gt : splitList(graphTypes)) {
+		for(auto sz : splitList(sizes)) {
+			for(auto nt : splitList(threads)) {
+
+				const unsigned N = std::stoul(sz);
+				const int nThreads = std::stoi(nt);
+				omp_set_num_threads(nThreads);
+				pinThreads(nThreads);
+
+				// The graph is built once, resetSort() undoes the previous run
+				Graph graph(N);
+				if(!connectGraph(graph, gt[0], edgeFillDegree, p, q, nChains)) return 1;
+				std::vector<double> timings;
+				std::string algorithm;
+				int nErrors = 0;
+				for(int r=-warmup; r<repetitions; ++r) {
+					graph.resetSort();
+					double t = graph.time_topSort();
+					if(r<0) continue; // warmup run
+					if(!graph.checkCorrect(false)) ++nErrors;
+					if(!graph.dumpSqliteAnalysis(dbFile, comment)) return 1;
+					timings.push_back(t);
+					algorithm = graph.getName();
+				}
+				if(timings.empty()) continue;
+
+				std::sort(timings.begin(), timings.end());
+				summary << algorithm << "\t" << gt << "\t" << N << "\t" << nThreads
+				        << "\tmedian " << quantile(timings,.5)
+				        << "\tIQR [" << quantile(timings,.25) << ", " << quantile(timings,.75) << "]"
+				        << "\terrors " << nErrors << "\n";
+			}
+		}
+	}
+
+	std::cout << "\n\nalgorithm\tgraph\tnodes\tthreads\ttotal time [sec] (" << repetitions << " repetitions, " << warmup << " warmup)\n";
+	std::cout << summary.str();
+	std::cout << "Results inserted into " << dbFile << std::endl;
+
+	return 0;
+}
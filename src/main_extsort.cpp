@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sys/stat.h>
+
+#include "analysis.hpp"
+#include "extmem.hpp"
+
+// Out-of-core topological sort of a graph stored as a binary edge list.
+// The edge file holds pairs (src,dst) of 32 bit node ids, the result is
+// written as a binary list of 32 bit node ids in topological order.
+int main(int argc, char* argv[]) {
+    if(argc < 3 || std::string(argv[1]) == "--help"){
+        std::cout << "Usage: ./extsort.exe edgeFile N [,outFile=order.bin [,tmpDir=/tmp [,memBudgetMB=1024 [,destDir=results]]]]" << std::endl;
+        return argc < 3 ? 1 : 0;
+    }
+    // Standard values
+    std::string edgeFile = argv[1];
+    extmem::type_index N = std::stoul(argv[2]);
+    std::string outFile = "order.bin";
+    std::string tmpDir = "/tmp";
+    extmem::type_offset budgetMB = 1024;
+    std::string out_dir = "results/";
+
+    // Read in command-line overrides
+    int cnt_arg = 3;
+    if(argc >= ++cnt_arg)
+        outFile = argv[cnt_arg-1];
+    if(argc >= ++cnt_arg)
+        tmpDir = argv[cnt_arg-1];
+    if(argc >= ++cnt_arg)
+        budgetMB = std::stoull(argv[cnt_arg-1]);
+    if(argc >= ++cnt_arg)
+        out_dir = argv[cnt_arg-1];
+
+    struct stat st;
+    if(stat(edgeFile.c_str(),&st) != 0) {
+        std::cerr << "Could not open file " << edgeFile << std::endl;
+        return 1;
+    }
+    extmem::type_offset nEdgesHint = st.st_size / (2*sizeof(extmem::type_index));
+
+    analysis A;
+    A.algorithmName_ = "extmem";
+    A.graphName_ = "FILE";
+    A.errorCode_ = 0;
+
+    extmem::iostats stats;
+    extmem::edgeStore es(N,nEdgesHint,budgetMB << 20,tmpDir,stats);
+
+    // Stream edges into the partitions
+    analysis::type_clock ingestclock;
+    ingestclock.start();
+    extmem::bufferedReader in(stats,1 << 20);
+    if(!in.open(edgeFile)) {
+        std::cerr << "Could not open file " << edgeFile << std::endl;
+        return 1;
+    }
+    extmem::type_index src, dst;
+    while(in.get(src) && in.get(dst)) {
+        if(src>=N || dst>=N) {
+            std::cerr << "Edge (" << src << "," << dst << ") out of range for N = " << N << std::endl;
+            return 1;
+        }
+        es.addEdge(src,dst);
+    }
+    in.close();
+    es.finalize();
+    ingestclock.stop();
+    std::cout << "Partitioned " << es.getNEdges() << " edges into " << es.getNPartitions() << " partitions in " << ingestclock.sec() << " sec\n";
+
+    A.nNodes_ = N;
+    A.nEdges_ = es.getNEdges();
+
+    // Start topological sorting
+    extmem::extSorter sorter(es,stats);
+    A.starttotaltiming();
+    A.depth_ = sorter.sort(outFile,A);
+    A.stoptotaltiming();
+    extmem::reportIO(stats,A);
+
+    std::cout << "\n\nMaximum Diameter: " << A.depth_;
+    std::cout << "\n\n\tSorting completed in:\t" << std::setprecision(8) << std::fixed << A.time_Total_ << " sec";
+    std::cout << "\n\tI/O read:\t" << stats.bytesRead_ << " bytes in " << stats.time_Read_ << " sec";
+    std::cout << "\n\tI/O written:\t" << stats.bytesWritten_ << " bytes in " << stats.time_Write_ << " sec\n\n";
+
+    A.xmlAnalysis(out_dir);
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <sched.h>
+#include <omp.h>
+
+#include "node.hpp"
+#include "aligned_allocator.hpp"
+#include "barrier.hpp"
+
+// Microbenchmarks of the synchronization primitives the engines are built
+// from, each in isolation: a team of threads runs the same operation ops
+// times, every thread times its own batch. Every thread and repetition gives
+// one sample in ns per operation, the distribution over all samples is printed
+// per primitive, contention level and thread count.
+//
+// The primitives are copies of the engine code, so that one binary measures
+// all variants regardless of the OPTIMISTIC flag it is built with:
+//   update		Node::requestValueUpdate, OPTIMISTIC=0 (critical), 1 (atomic), 2 (atomic + CAS)
+//   gather		gatherlist of omp_locallist and omp_worksteal, splice under critical
+//   scatter	scatterlist of omp_locallist, take the first n nodes under critical
+//   steal		threadLocallist::trySteal of omp_worksteal, pop_back under critical
+//   barrier	#pragma omp barrier, and spin::barrier (barrier.hpp) with its fused sum
+
+using type_nodeptr = std::shared_ptr<Node>;
+using type_nodelist = std::list<type_nodeptr>;
+
+// PRE:		str is a comma separated list
+// POST:	returns the list elements
+static std::vector<std::string> splitList(const std::string& str) {
+	std::vector<std::string> items;
+	std::stringstream ss(str);
+	std::string item;
+	while(std::getline(ss,item,',')) {
+		if(!item.empty()) items.push_back(item);
+	}
+	return items;
+}
+
+// Pins thread i of a team of nThreads to processor i (round robin), as main_benchmark
+static void pinThreads(int nThreads) {
+	if(std::getenv("OMP_PROC_BIND") || std::getenv("OMP_PLACES")) return;
+	const int nProcs = omp_get_num_procs();
+	#pragma omp parallel num_threads(nThreads)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(omp_get_thread_num() % nProcs, &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+}
+
+// PRE:		sorted is sorted and not empty
+// POST:	returns the q-quantile (linear interpolation, as numpy.percentile)
+static double quantile(const std::vector<double>& sorted, double q) {
+	double pos = q * (sorted.size()-1);
+	std::size_t lo = static_cast<std::size_t>(pos);
+	std::size_t hi = std::min(lo+1, sorted.size()-1);
+	return sorted[lo] + (pos-lo) * (sorted[hi]-sorted[lo]);
+}
+
+//------------------------------ update ------------------------------
+
+// The state requestValueUpdate works on
+struct counter {
+	unsigned parcount_;
+	bool taken_;
+};
+
+// a counter on a cache line of its own
+struct alignas(util::cacheline) paddedCounter {
+	counter c_;
+};
+
+inline bool updateCritical(counter& c) {
+	bool lastone;
+	#pragma omp critical
+	{
+	--c.parcount_;
+	lastone = (c.parcount_ == 0);
+	}
+	return lastone;
+}
+
+inline bool updateAtomic(counter& c) {
+	#pragma omp atomic
+	--c.parcount_;
+	return (c.parcount_ == 0);
+}
+
+inline bool updateCAS(counter& c) {
+	#pragma omp atomic
+	--c.parcount_;
+	bool swapped = false;
+	if(c.parcount_ == 0)
+		swapped = __sync_bool_compare_and_swap(&c.taken_, false, true);
+	return swapped;
+}
+
+// Contention:	shared		one counter for the whole team (a node with many parents)
+//				adjacent	a counter per thread, neighbours share a cache line
+//				padded		a counter per thread on a cache line of its own
+// POST:	samples holds nThreads*repetitions values in ns/op
+template <bool (*update)(counter&)>
+static void benchUpdate(const std::string& contention, int nThreads, int repetitions, long ops, std::vector<double>& samples) {
+	std::vector<counter> adjacent(nThreads);
+	std::vector<paddedCounter, util::aligned_allocator<paddedCounter>> padded(nThreads);
+	const unsigned start = static_cast<unsigned>(ops) * nThreads + 1; // never reaches 0, every call takes the same path
+	long last = 0;
+
+	for(int r = 0; r < repetitions; ++r) {
+		for(int t = 0; t < nThreads; ++t) {
+			adjacent[t] = counter{start, false};
+			padded[t].c_ = counter{start, false};
+		}
+		#pragma omp parallel num_threads(nThreads) reduction(+:last)
+		{
+			const int tid = omp_get_thread_num();
+			counter& c = contention == "shared" ? padded[0].c_ : contention == "adjacent" ? adjacent[tid] : padded[tid].c_;
+			#pragma omp barrier
+			const double t0 = omp_get_wtime();
+			for(long i = 0; i < ops; ++i) last += update(c);
+			const double t1 = omp_get_wtime();
+			#pragma omp critical
+			samples.push_back((t1 - t0) * 1e9 / ops);
+		}
+	}
+	if(last != 0) std::cerr << "\nERROR:\tcounter reached 0" << std::endl;
+}
+
+//------------------------------ gather, scatter ------------------------------
+
+// Every thread splices ops lists of n nodes into the global list (gather), then
+// takes ops times n nodes from its front (scatter). Contention: the list length n.
+// POST:	gather and scatter hold nThreads*repetitions values in ns/op each
+static void benchGatherScatter(long n, int nThreads, int repetitions, long ops, std::vector<double>& gather, std::vector<double>& scatter) {
+	const type_nodeptr node = std::make_shared<Node>(0);
+	type_nodelist globallist;
+
+	for(int r = 0; r < repetitions; ++r) {
+		#pragma omp parallel num_threads(nThreads)
+		{
+			std::vector<type_nodelist> locallists(ops, type_nodelist(n, node));
+			#pragma omp barrier
+			double t0 = omp_get_wtime();
+			for(long i = 0; i < ops; ++i) {
+				#pragma omp critical
+				{
+					globallist.splice(globallist.end(),locallists[i]);
+				}
+			}
+			double t1 = omp_get_wtime();
+			#pragma omp critical
+			gather.push_back((t1 - t0) * 1e9 / ops);
+			#pragma omp barrier
+
+			t0 = omp_get_wtime();
+			for(long i = 0; i < ops; ++i) {
+				type_nodelist::iterator start, end;
+				#pragma omp critical
+				{
+					const long len = globallist.size();
+					start = globallist.begin();
+					end = globallist.begin();
+					std::advance(end,std::min(n,len));
+					locallists[i].splice(locallists[i].end(),globallist,start,end);
+				}
+			}
+			t1 = omp_get_wtime();
+			#pragma omp critical
+			scatter.push_back((t1 - t0) * 1e9 / ops);
+		}
+	}
+}
+
+//------------------------------ steal ------------------------------
+
+// Every thread steals ops nodes. Contention:	neighbour	from the stack of thread tid+1
+//												onevictim	all threads from the stack of thread 0
+// POST:	samples holds nThreads*repetitions values in ns/op
+static void benchSteal(const std::string& contention, int nThreads, int repetitions, long ops, std::vector<double>& samples) {
+	const type_nodeptr node = std::make_shared<Node>(0);
+	const bool one = contention == "onevictim";
+	std::vector<type_nodelist> stacks(nThreads);
+	long missed = 0;
+
+	for(int r = 0; r < repetitions; ++r) {
+		for(int t = 0; t < nThreads; ++t) {
+			stacks[t].assign((one ? (t == 0 ? nThreads : 0) : 1) * ops, node);
+		}
+		#pragma omp parallel num_threads(nThreads) reduction(+:missed)
+		{
+			const int tid = omp_get_thread_num();
+			type_nodelist& victim = stacks[one ? 0 : (tid + 1) % nThreads];
+			#pragma omp barrier
+			const double t0 = omp_get_wtime();
+			for(long i = 0; i < ops; ++i) {
+				type_nodeptr nd = nullptr;
+				#pragma omp critical
+				{
+					if(!victim.empty()) {
+						nd = victim.back();
+						victim.pop_back();
+					}
+				}
+				if(!nd) ++missed;
+			}
+			const double t1 = omp_get_wtime();
+			#pragma omp critical
+			samples.push_back((t1 - t0) * 1e9 / ops);
+		}
+	}
+	if(missed != 0) std::cerr << "\nERROR:\t" << missed << " steals found an empty stack" << std::endl;
+}
+
+//------------------------------ barrier ------------------------------
+
+// Kind:	omp		#pragma omp barrier
+//			spin	spin::barrier, every thread adds 1
+// POST:	samples holds nThreads*repetitions values in ns per barrier
+static void benchBarrier(const std::string& kind, int nThreads, int repetitions, long ops, std::vector<double>& samples) {
+	spin::barrier sb;
+	long wrong = 0;
+	for(int r = 0; r < repetitions; ++r) {
+		#pragma omp parallel num_threads(nThreads) reduction(+:wrong)
+		{
+			const int tid = omp_get_thread_num();
+			#pragma omp single
+			sb.reset(omp_get_num_threads());
+			const double t0 = omp_get_wtime();
+			if(kind == "spin") {
+				for(long i = 0; i < ops; ++i) wrong += sb.sum(tid, 1) != nThreads;
+			} else {
+				for(long i = 0; i < ops; ++i) {
+					#pragma omp barrier
+				}
+			}
+			const double t1 = omp_get_wtime();
+			#pragma omp critical
+			samples.push_back((t1 - t0) * 1e9 / ops);
+		}
+	}
+	if(wrong != 0) std::cerr << "\nERROR:\t" << wrong << " spin barriers returned a wrong sum" << std::endl;
+}
+
+//------------------------------ main ------------------------------
+
+// One line of the result table
+static void report(const std::string& primitive, const std::string& contention, int nThreads, std::vector<double>& samples) {
+	if(samples.empty()) return;
+	std::sort(samples.begin(), samples.end());
+	double mean = 0;
+	for(double s : samples) mean += s;
+	mean /= samples.size();
+	std::cout << std::setw(16) << std::left << primitive << std::setw(12) << contention << std::right
+	          << std::setw(8) << nThreads
+	          << std::setw(12) << mean
+	          << std::setw(12) << samples.front()
+	          << std::setw(12) << quantile(samples,.5)
+	          << std::setw(12) << quantile(samples,.9)
+	          << std::setw(12) << quantile(samples,.99)
+	          << std::setw(12) << samples.back() << std::endl;
+	samples.clear();
+}
+
+int main(int argc, char* argv[]) {
+	if(argc == 2 && std::string(argv[1]) == "--help"){
+		std::cout << "Usage: ./microbench.exe [threads=1,2,4,..,max [,repetitions=20 [,ops=10000 [,primitives=update,gather,scatter,steal,barrier]]]]" << std::endl;
+		std::cout << "threads and primitives are comma separated lists, e.g. 1,2,4,8 update,barrier" << std::endl;
+		std::cout << "Every thread and repetition is one sample, the columns are the distribution over the samples in ns/op" << std::endl;
+		return 0;
+	}
+	// Standard values
+	std::string threads;
+	for(int t = 1; t < omp_get_max_threads(); t *= 2) threads += std::to_string(t) + ",";
+	threads += std::to_string(omp_get_max_threads());
+	int repetitions = 20;
+	long ops = 10000;
+	std::string primitives = "update,gather,scatter,steal,barrier";
+
+	// Read in command-line overrides
+	int cnt_arg = 1;
+	if(argc >= ++cnt_arg)
+		threads = argv[cnt_arg-1];
+	if(argc >= ++cnt_arg)
+		repetitions = std::stoi(argv[cnt_arg-1]);
+	if(argc >= ++cnt_arg)
+		ops = std::stol(argv[cnt_arg-1]);
+	if(argc >= ++cnt_arg)
+		primitives = argv[cnt_arg-1];
+	if(repetitions < 1 || ops < 1) {
+		std::cerr << "\nERROR:\trepetitions and ops must be positive" << std::endl;
+		return 1;
+	}
+
+	const std::vector<std::string> selected = splitList(primitives);
+	auto wanted = [&](const std::string& p) {
+		return std::find(selected.begin(), selected.end(), p) != selected.end();
+	};
+	const char* contentions[] = {"shared", "adjacent", "padded"};
+	const char* listLengths[] = {"1", "64"};
+	const char* victims[] = {"neighbour", "onevictim"};
+
+	std::cout << std::setprecision(2) << std::fixed;
+	std::cout << std::setw(16) << std::left << "primitive" << std::setw(12) << "contention" << std::right
+	          << std::setw(8) << "threads" << std::setw(12) << "mean" << std::setw(12) << "min"
+	          << std::setw(12) << "median" << std::setw(12) << "p90" << std::setw(12) << "p99"
+	          << std::setw(12) << "max" << "   [ns/op, " << repetitions << " repetitions x " << ops << " ops]" << std::endl;
+
+	for(auto nt : splitList(threads)) {
+		const int nThreads = std::stoi(nt);
+		if(nThreads < 1) continue;
+		pinThreads(nThreads);
+		std::vector<double> samples, more;
+
+		if(wanted("update")) {
+			for(const char* c : contentions) {
+				benchUpdate<updateCritical>(c, nThreads, repetitions, ops, samples);
+				report("update/critical", c, nThreads, samples);
+				benchUpdate<updateAtomic>(c, nThreads, repetitions, ops, samples);
+				report("update/atomic", c, nThreads, samples);
+				benchUpdate<updateCAS>(c, nThreads, repetitions, ops, samples);
+				report("update/cas", c, nThreads, samples);
+			}
+		}
+		if(wanted("gather") || wanted("scatter")) {
+			for(const char* n : listLengths) {
+				benchGatherScatter(std::stol(n), nThreads, repetitions, ops, samples, more);
+				if(wanted("gather")) report("gather", std::string("n=") + n, nThreads, samples);
+				if(wanted("scatter")) report("scatter", std::string("n=") + n, nThreads, more);
+				samples.clear();
+				more.clear();
+			}
+		}
+		if(wanted("steal")) {
+			for(const char* v : victims) {
+				benchSteal(v, nThreads, repetitions, ops, samples);
+				report("steal", v, nThreads, samples);
+			}
+		}
+		if(wanted("barrier")) {
+			for(const char* k : {"omp", "spin"}) {
+				benchBarrier(k, nThreads, repetitions, ops, samples);
+				report("barrier", k, nThreads, samples);
+			}
+		}
+	}
+
+	return 0;
+}
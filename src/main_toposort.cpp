@@ -1,14 +1,46 @@
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <omp.h>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "graph.hpp"
 #include "analysis.hpp"
 
+// Passes the outcome of the sort to the auto mode (main_auto.cpp), which
+// sets TOPOSORT_RESULTFILE before it starts the engine
+static void writeResult(analysis::type_time time, bool correct) {
+    const char* env_result = std::getenv("TOPOSORT_RESULTFILE");
+    if(!env_result) return;
+    std::ofstream f(env_result);
+    f << time << " " << correct << "\n";
+}
+
+// Seeds of the reachable-region queries: TOPOSORT_REACH_SEEDS="id,id,...",
+// by default four nodes spread over the graph
+static std::vector<Node::type_index> reachSeeds(unsigned N) {
+    std::vector<Node::type_index> seeds;
+    const char* env_seeds = std::getenv("TOPOSORT_REACH_SEEDS");
+    if(env_seeds) {
+        std::stringstream ss(env_seeds);
+        std::string id;
+        while(std::getline(ss, id, ',')) {
+            unsigned long v = std::stoul(id);
+            if(v < N) seeds.push_back(v);
+            else std::cerr << "\nERROR:\tseed " << v << " is not a node of the graph, ignored";
+        }
+    } else {
+        for(unsigned k = 0; k < 4; ++k) seeds.push_back((static_cast<unsigned long>(N) * k) / 4);
+    }
+    return seeds;
+}
+
 int main(int argc, char* argv[]) {
     if(argc == 2 && std::string(argv[1]) == "--help"){
         std::cout << "Usage: ./toposort_xyz.exe [graphType = s [,N=5000 [,destDir=results [,edgeFillDegree = 2.7 [,p = 0.5, q = 0.7 [,nChains = 100]]]]]]" << std::endl;
-        std::cout << "Graph Types: t: Test graphs (Paper and small Random)\ts: Software\tr: Random \tc: Chain\tm: Mulitchain" << std::endl;
+        std::cout << "Graph Types: t: Test graphs (Paper and small Random)\ts: Software\tr: Random \tc: Chain\tm: Mulitchain\tq: Reachable regions of a Software graph" << std::endl;
         return 0;
     }
     // Standard values
@@ -77,8 +109,8 @@ int main(int argc, char* argv[]) {
             std::cout << visualbarrier;
             Graph testgraph_random(N);
             testgraph_random.connect(Graph::RANDOM_LIN, edgeFillDegree);
-            testgraph_random.time_topSort();
-            testgraph_random.checkCorrect(false);
+            auto time = testgraph_random.time_topSort();
+            writeResult(time, testgraph_random.checkCorrect(false));
             testgraph_random.dumpXmlAnalysis(out_dir);
             break;
         }
@@ -89,20 +121,37 @@ int main(int argc, char* argv[]) {
             std::cout << visualbarrier;
             Graph softwaregraph(N);
             softwaregraph.connect(Graph::SOFTWARE, 0., p, q);
-            softwaregraph.time_topSort();
-            softwaregraph.checkCorrect(false);
+            auto time = softwaregraph.time_topSort();
+            writeResult(time, softwaregraph.checkCorrect(false));
             softwaregraph.dumpXmlAnalysis(out_dir);
             break;
         }
         
+        case 'q':
+        {
+            // SOFTWARE GRAPH - partial sorts from seeds (sortReachable), both directions
+            std::cout << visualbarrier;
+            Graph softwaregraph(N);
+            softwaregraph.connect(Graph::SOFTWARE, 0., p, q);
+            const std::vector<Node::type_index> seeds = reachSeeds(N);
+            for(auto dir : {reach::DOWNSTREAM, reach::UPSTREAM}) {
+                double start = omp_get_wtime();
+                Graph::type_nodelist region = softwaregraph.sortReachable(seeds, dir);
+                std::cout << "\n" << (dir == reach::DOWNSTREAM ? "Downstream" : "Upstream")
+                          << " region sorted in " << omp_get_wtime() - start << " sec";
+                softwaregraph.checkReachable(seeds, dir, region, false);
+            }
+            break;
+        }
+
         case 'c':
         {
             // CHAIN GRAPH - MEDIUM
             std::cout << visualbarrier;
             Graph testgraph_chain(N);
             testgraph_chain.connect(Graph::CHAIN);
-            testgraph_chain.time_topSort();
-            testgraph_chain.checkCorrect(false);
+            auto time = testgraph_chain.time_topSort();
+            writeResult(time, testgraph_chain.checkCorrect(false));
             testgraph_chain.dumpXmlAnalysis(out_dir);
             break;
         }
@@ -113,15 +162,15 @@ int main(int argc, char* argv[]) {
             std::cout << visualbarrier;
             Graph testgraph_multichain(N);
             testgraph_multichain.connect(Graph::MULTICHAIN, 0., 0., 0., nChains);
-            testgraph_multichain.time_topSort();
-            testgraph_multichain.checkCorrect(false);
+            auto time = testgraph_multichain.time_topSort();
+            writeResult(time, testgraph_multichain.checkCorrect(false));
             testgraph_multichain.dumpXmlAnalysis(out_dir);
             break;
         }
         
         default:
             std::cout << "Unknown Graph Type " << graphType << std::endl;
-            std::cout << "Graph Types: t: Test graphs (Paper and small Random)\ts: Software\tr: Random \tc: Chain\tm: Mulitchain" << std::endl;
+            std::cout << "Graph Types: t: Test graphs (Paper and small Random)\ts: Software\tr: Random \tc: Chain\tm: Mulitchain\tq: Reachable regions of a Software graph" << std::endl;
     }
 
 	std::cout << visualbarrier;
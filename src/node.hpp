@@ -32,6 +32,13 @@ class Node {
 		void addChild(std::shared_ptr<Node> child);
 		bool hasChild(std::shared_ptr<Node> childCandidate);
 
+		// POST:	the node is unsorted again, with parcount parents left (see Graph::resetSort)
+		inline void resetState(unsigned parcount) {
+			parcount_ = parcount;
+			v_ = (parcount == 0) ? 1 : 0;
+			taken_ = false;
+		}
+
 		inline type_value getValue() const {
 			return v_;
 		}
@@ -53,6 +60,24 @@ class Node {
 			return childcount_;
 		}
 
+		// Stages of the prefetch pipeline (prefetch.hpp), return the number of prefetches issued
+		// POST:	the child pointers are on their way
+		inline std::size_t prefetchChildList() const {
+			__builtin_prefetch(childnodes_.data(), 0, 3);
+			return 1;
+		}
+		// POST:	the first (at most limit) children, i.e. their parcount_, are on their way
+		inline std::size_t prefetchChildren(std::size_t limit) const {
+			const std::size_t n = childcount_ < limit ? childcount_ : limit;
+			for(std::size_t c = 0; c < n; ++c) __builtin_prefetch(childnodes_[c].get(), 1, 3);
+			return n;
+		}
+
+		// bytes of the node and its child list, without the children
+		inline std::size_t bytes() const {
+			return sizeof(Node) + childnodes_.capacity() * sizeof(type_nodecontainer::value_type);
+		}
+
 #if OPTIMISTIC == 1
 		inline bool requestValueUpdate() {
 			#pragma omp atomic
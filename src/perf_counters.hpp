@@ -0,0 +1,120 @@
+// File:    perf_counters.hpp
+// Hardware performance counters of the calling thread through perf_event_open (Linux)
+
+#ifndef UTIL_PERF_COUNTERS_HEADER
+#define UTIL_PERF_COUNTERS_HEADER
+
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace util {
+
+    // Events that are counted, in the order they are stored
+    enum perfevent {CYCLES, INSTRUCTIONS, LLCMISSES, DTLBMISSES, BRANCHMISSES, N_PERFEVENT};
+
+    // Accumulated counter values
+    struct perf_values {
+        perf_values() {
+            clear();
+        }
+        void clear() {
+            std::memset(v, 0, sizeof(v));
+        }
+        perf_values& operator+=(perf_values const & other) {
+            for(int e = 0; e < N_PERFEVENT; ++e) v[e] += other.v[e];
+            return *this;
+        }
+        double ipc() const {
+            return v[CYCLES] > 0 ? static_cast<double>(v[INSTRUCTIONS]) / v[CYCLES] : 0.;
+        }
+        uint64_t v[N_PERFEVENT];
+    };
+
+    // One group of counters bound to the thread that called open().
+    // All events are read with a single read() system call. Events the CPU or
+    // the kernel (perf_event_paranoid, virtual machines) refuse stay at zero.
+    class perf_counters {
+    public:
+        perf_counters()
+            : leader_(-1)
+            , nOpen_(0)
+        {
+            for(int e = 0; e < N_PERFEVENT; ++e) fd_[e] = -1;
+        }
+        ~perf_counters() {
+            close();
+        }
+        perf_counters(perf_counters const &) = delete;
+        perf_counters& operator=(perf_counters const &) = delete;
+
+        //--------------------------- methods ----------------------------------
+        // PRE:  must be called by the thread that is to be measured
+        // POST: returns true if at least one event is counted
+        bool open() {
+            close();
+            const uint64_t llc = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const uint64_t dtlb = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const uint32_t types[N_PERFEVENT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+            const uint64_t configs[N_PERFEVENT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, llc, dtlb, PERF_COUNT_HW_BRANCH_MISSES};
+
+            for(int e = 0; e < N_PERFEVENT; ++e) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = types[e];
+                attr.config = configs[e];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.disabled = (leader_ < 0) ? 1 : 0;
+                fd_[e] = syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0); // this thread, any cpu
+                if(fd_[e] < 0) continue;
+                if(leader_ < 0) leader_ = fd_[e];
+                slot_[nOpen_++] = e;
+            }
+            if(leader_ < 0) return false;
+            ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            return true;
+        }
+        void close() {
+            for(int e = 0; e < N_PERFEVENT; ++e) {
+                if(fd_[e] >= 0) ::close(fd_[e]);
+                fd_[e] = -1;
+            }
+            leader_ = -1;
+            nOpen_ = 0;
+        }
+        // POST: res holds the current (free running) counter values
+        void read(perf_values & res) const {
+            res.clear();
+            if(leader_ < 0) return;
+            uint64_t buf[1 + N_PERFEVENT];
+            if(::read(leader_, buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t))) return;
+            for(uint64_t i = 0; i < buf[0] && i < static_cast<uint64_t>(nOpen_); ++i) res.v[slot_[i]] = buf[1 + i];
+        }
+        //------------------------- const methods ------------------------------
+        bool valid() const {
+            return leader_ >= 0;
+        }
+    private:
+        int fd_[N_PERFEVENT];
+        int slot_[N_PERFEVENT]; // slot_[i] = event of the i-th value in a group read
+        int leader_;
+        int nOpen_;
+    };
+
+    // Difference of two readings
+    inline perf_values operator-(perf_values const & end, perf_values const & begin) {
+        perf_values res;
+        for(int e = 0; e < N_PERFEVENT; ++e) res.v[e] = end.v[e] - begin.v[e];
+        return res;
+    }
+
+} // end namespace util
+
+#endif // UTIL_PERF_COUNTERS_HEADER
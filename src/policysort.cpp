@@ -0,0 +1,45 @@
+#include "policysort.hpp"
+
+namespace policysort {
+
+	// The combinations that can be picked at run time
+	#define POLICYSORT_INSTANTIATE(ATOMIC, FRONTIER) \
+		template struct toposort<topology, ATOMIC, FRONTIER, noInstrumentation>; \
+		template struct toposort<topology, ATOMIC, FRONTIER, countingInstrumentation>;
+
+	POLICYSORT_INSTANTIATE(serialUpdate, levelFrontier)
+	POLICYSORT_INSTANTIATE(serialUpdate, stackFrontier)
+	POLICYSORT_INSTANTIATE(atomicUpdate, levelFrontier)
+	POLICYSORT_INSTANTIATE(atomicUpdate, stackFrontier)
+	POLICYSORT_INSTANTIATE(criticalUpdate, levelFrontier)
+	POLICYSORT_INSTANTIATE(criticalUpdate, stackFrontier)
+
+	#undef POLICYSORT_INSTANTIATE
+
+	template <typename Atomic, typename Frontier>
+	static topology::type_index dispatch(sortState& st, int nThreads, countingInstrumentation* counts) {
+		if(counts) {
+			return toposort<topology, Atomic, Frontier, countingInstrumentation>::run(st, *counts, nThreads);
+		}
+		noInstrumentation none;
+		return toposort<topology, Atomic, Frontier, noInstrumentation>::run(st, none, nThreads);
+	}
+
+	template <typename Atomic>
+	static bool dispatch(const std::string& frontier, sortState& st, int nThreads,
+		countingInstrumentation* counts, topology::type_index& depth) {
+		if(frontier == "levels") depth = dispatch<Atomic, levelFrontier>(st, nThreads, counts);
+		else if(frontier == "stack") depth = dispatch<Atomic, stackFrontier>(st, nThreads, counts);
+		else return false;
+		return true;
+	}
+
+	bool run(const std::string& atomic, const std::string& frontier, sortState& st, int nThreads,
+		countingInstrumentation* counts, topology::type_index& depth) {
+		if(atomic == "serial") return dispatch<serialUpdate>(frontier, st, nThreads, counts, depth);
+		if(atomic == "atomic") return dispatch<atomicUpdate>(frontier, st, nThreads, counts, depth);
+		if(atomic == "critical") return dispatch<criticalUpdate>(frontier, st, nThreads, counts, depth);
+		return false;
+	}
+
+} // end namespace policysort
@@ -0,0 +1,275 @@
+#ifndef POLICYSORT_HPP
+#define POLICYSORT_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "aligned_allocator.hpp"
+#include "topology.hpp"
+#include "sortstate.hpp"
+
+// Header-only sort on a CSR topology, assembled from compile-time policies:
+//
+//   policysort::toposort<Topology, AtomicPolicy, FrontierPolicy, InstrumentationPolicy>::run(st, instr)
+//
+// AtomicPolicy			how a parent releases a child: serialUpdate, atomicUpdate, criticalUpdate
+//						(the OPTIMISTIC=1 / OPTIMISTIC=0 variants of Node::requestValueUpdate)
+// FrontierPolicy		how ready nodes are scheduled: levelFrontier (one barrier per level),
+//						stackFrontier (no barrier, every thread drains its own stack)
+// InstrumentationPolicy	what is counted: noInstrumentation (compiles to nothing), countingInstrumentation
+//
+// Unlike the -D build variants, any combination can live in one binary. The
+// common ones are instantiated in policysort.cpp and can be picked by name at run time.
+namespace policysort {
+
+	//------------------------------ atomic policies ------------------------------
+
+	// One thread only, plain decrements
+	struct serialUpdate {
+		static const bool parallel = false;
+		template <typename State>
+		static inline bool release(State& st, typename State::type_index v) {
+			return st.decrementSerial(v);
+		}
+		template <typename State>
+		static inline void raise(State& st, typename State::type_index v, typename State::type_index level) {
+			if(st.level(v) < level) st.setLevel(v, level);
+		}
+	};
+
+	// Atomic fetch-and-sub, OPTIMISTIC=1
+	struct atomicUpdate {
+		static const bool parallel = true;
+		template <typename State>
+		static inline bool release(State& st, typename State::type_index v) {
+			return st.decrement(v);
+		}
+		template <typename State>
+		static inline void raise(State& st, typename State::type_index v, typename State::type_index level) {
+			st.raiseLevel(v, level);
+		}
+	};
+
+	// Every update in one critical section, OPTIMISTIC=0
+	struct criticalUpdate {
+		static const bool parallel = true;
+		template <typename State>
+		static inline bool release(State& st, typename State::type_index v) {
+			bool last;
+			#pragma omp critical (policysort_update)
+			last = st.decrementSerial(v);
+			return last;
+		}
+		template <typename State>
+		static inline void raise(State& st, typename State::type_index v, typename State::type_index level) {
+			#pragma omp critical (policysort_update)
+			if(st.level(v) < level) st.setLevel(v, level);
+		}
+	};
+
+	//--------------------------- instrumentation policies ---------------------------
+
+	struct noInstrumentation {
+		inline void begin(int) {}
+		inline void node(int) {}
+		inline void edges(int, std::size_t) {}
+		inline void level(std::size_t) {}
+	};
+
+	// Processed nodes and edges per thread, number of synchronized rounds
+	class countingInstrumentation {
+
+		public:
+
+			inline void begin(int nThreads) {
+				counters_.assign(nThreads, counter());
+				rounds_ = 0;
+			}
+			inline void node(int tid) {
+				++counters_[tid].nodes_;
+			}
+			inline void edges(int tid, std::size_t n) {
+				counters_[tid].edges_ += n;
+			}
+			inline void level(std::size_t) {
+				++rounds_;
+			}
+
+			std::size_t nodes() const {
+				std::size_t n = 0;
+				for(const auto& c : counters_) n += c.nodes_;
+				return n;
+			}
+			std::size_t edges() const {
+				std::size_t n = 0;
+				for(const auto& c : counters_) n += c.edges_;
+				return n;
+			}
+			// largest share of the nodes a single thread processed
+			double imbalance() const {
+				std::size_t most = 0;
+				for(const auto& c : counters_) most = std::max(most, c.nodes_);
+				const std::size_t total = nodes();
+				return total > 0 ? static_cast<double>(most) * counters_.size() / total : 1.;
+			}
+			std::size_t rounds() const {
+				return rounds_;
+			}
+
+		private:
+
+			struct alignas(util::cacheline) counter {
+				std::size_t nodes_ = 0;
+				std::size_t edges_ = 0;
+			};
+			std::vector<counter, util::aligned_allocator<counter>> counters_;
+			std::size_t rounds_ = 0;
+	};
+
+	//------------------------------ frontier policies -------------------------------
+
+	// Level-synchronous, the order array is the queue (as csrsort::levels)
+	struct levelFrontier {
+
+		template <typename Atomic, typename State, typename Instrumentation>
+		static typename State::type_index sort(State& st, Instrumentation& instr, int nThreads) {
+			using type_index = typename State::type_index;
+			const typename State::type_topology& topo = st.getTopology();
+			const type_index N = topo.size();
+			instr.begin(nThreads);
+
+			type_index begin = 0;
+			type_index end = 0;
+			type_index depth = 0;
+
+			#pragma omp parallel num_threads(nThreads) if(Atomic::parallel)
+			{
+				const int tid = omp_get_thread_num();
+				std::vector<type_index> next_local;
+
+				#pragma omp for schedule(static) nowait
+				for(type_index v = 0; v < N; ++v) {
+					if(st.indegree(v) == 0) next_local.push_back(v);
+				}
+				type_index slot = st.reserve(next_local.size());
+				for(auto v : next_local) st.put(slot++, v);
+				next_local.clear();
+				#pragma omp barrier
+
+				#pragma omp single
+				end = st.size();
+
+				while(begin < end) {
+					const type_index childlevel = depth + 1;
+					#pragma omp for schedule(dynamic, 256) nowait
+					for(type_index i = begin; i < end; ++i) {
+						const type_index parent = st.order()[i];
+						instr.node(tid);
+						instr.edges(tid, topo.childCount(parent));
+						for(const type_index* c = topo.childBegin(parent); c != topo.childEnd(parent); ++c) {
+							if(Atomic::release(st, *c)) {
+								st.setLevel(*c, childlevel);
+								next_local.push_back(*c);
+							}
+						}
+					}
+					slot = st.reserve(next_local.size());
+					for(auto v : next_local) st.put(slot++, v);
+					next_local.clear();
+					#pragma omp barrier
+
+					#pragma omp single
+					{
+						instr.level(end - begin);
+						begin = end;
+						end = st.size();
+						++depth;
+					} // implicit barrier
+				}
+			} // end of OMP parallel
+			return depth;
+		}
+	};
+
+	// No barrier after the sources: every thread sorts what its sources release
+	// on a private stack. A batch is placed in the order before it releases any
+	// child, so the order stays topological. The levels are raised per edge.
+	struct stackFrontier {
+
+		static const std::size_t batch = 64;
+
+		template <typename Atomic, typename State, typename Instrumentation>
+		static typename State::type_index sort(State& st, Instrumentation& instr, int nThreads) {
+			using type_index = typename State::type_index;
+			const typename State::type_topology& topo = st.getTopology();
+			const type_index N = topo.size();
+			instr.begin(nThreads);
+			type_index depth = 0;
+
+			#pragma omp parallel num_threads(nThreads) if(Atomic::parallel) reduction(max:depth)
+			{
+				const int tid = omp_get_thread_num();
+				std::vector<type_index> stack;
+
+				#pragma omp for schedule(static)
+				for(type_index v = 0; v < N; ++v) {
+					if(st.indegree(v) == 0) stack.push_back(v);
+				} // implicit barrier: no source is released before all are found
+
+				type_index current[batch];
+				while(!stack.empty()) {
+					const std::size_t n = stack.size() < batch ? stack.size() : batch;
+					type_index slot = st.reserve(n);
+					for(std::size_t i = 0; i < n; ++i) {
+						current[i] = stack.back();
+						stack.pop_back();
+						st.put(slot++, current[i]);
+					}
+					for(std::size_t i = 0; i < n; ++i) {
+						const type_index parent = current[i];
+						const type_index childlevel = st.level(parent) + 1;
+						depth = std::max(depth, childlevel);
+						instr.node(tid);
+						instr.edges(tid, topo.childCount(parent));
+						for(const type_index* c = topo.childBegin(parent); c != topo.childEnd(parent); ++c) {
+							Atomic::raise(st, *c, childlevel);
+							if(Atomic::release(st, *c)) stack.push_back(*c);
+						}
+					}
+				}
+			} // end of OMP parallel
+			instr.level(N);
+			return depth;
+		}
+	};
+
+	//------------------------------------ sort --------------------------------------
+
+	template <typename Topology, typename AtomicPolicy, typename FrontierPolicy, typename InstrumentationPolicy>
+	struct toposort {
+
+		using type_state = basic_sortState<Topology>;
+		using type_index = typename Topology::type_index;
+
+		// PRE:		st is reset
+		// POST:	st holds a topological order and the level of every node, returns the depth
+		static type_index run(type_state& st, InstrumentationPolicy& instr, int nThreads = 0) {
+			if(nThreads <= 0) nThreads = omp_get_max_threads();
+			if(!AtomicPolicy::parallel) nThreads = 1;
+			return FrontierPolicy::template sort<AtomicPolicy>(st, instr, nThreads);
+		}
+	};
+
+	//------------------------------ run-time selection ------------------------------
+
+	// PRE:		atomic is serial|atomic|critical, frontier levels|stack
+	// POST:	sorts st with the instantiation of these policies (counting into counts
+	//			if not null), returns false if there is none
+	bool run(const std::string& atomic, const std::string& frontier, sortState& st, int nThreads,
+		countingInstrumentation* counts, topology::type_index& depth);
+
+} // end namespace policysort
+
+#endif // POLICYSORT_HPP
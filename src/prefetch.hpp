@@ -0,0 +1,155 @@
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+
+// Software prefetch pipeline for the child-decrement loops.
+//
+// Releasing a child costs two dependent random accesses: the child list of
+// the parent and then the counter of every child. The hardware prefetcher
+// cannot predict either, so a thread sees one miss at a time. The pipeline
+// runs ahead of the frontier in two stages:
+//
+//   far	(2*distance parents ahead)	prefetch the child list of the parent
+//   near	(  distance parents ahead)	read the child list, prefetch the counter of every child
+//
+// The parent being processed then finds its counters in cache, and the
+// misses of up to distance parents overlap. The frontier is processed in
+// groups of distance parents, each group issues the prefetches of the group
+// distance parents later. Distance 0 turns the pipeline off.
+namespace prefetch {
+
+	// counters prefetched per parent at most, more would evict the ones still in flight
+	static const std::size_t fanoutLimit = 16;
+
+	// POST:	returns the prefetch distance in parents, TOPOSORT_PREFETCH overrides defaultDistance
+	inline std::size_t distance(std::size_t defaultDistance = 8) {
+		const char* env = std::getenv("TOPOSORT_PREFETCH");
+		return env ? std::strtoul(env, nullptr, 10) : defaultDistance;
+	}
+
+	template <typename T>
+	inline void read(const T* p) {
+		__builtin_prefetch(p, 0, 3);
+	}
+
+	template <typename T>
+	inline void write(const T* p) {
+		__builtin_prefetch(p, 1, 3);
+	}
+
+	//------------------------------ CSR stages ------------------------------
+
+	// POST:	the start of the child list of v is on its way, returns 1
+	template <typename Topology>
+	inline std::size_t childList(const Topology& topo, typename Topology::type_index v) {
+		read(topo.childBegin(v));
+		return 1;
+	}
+
+	// POST:	the counters of the first children of v are on their way, returns their number
+	template <typename Topology, typename Counter>
+	inline std::size_t counters(const Topology& topo, typename Topology::type_index v, Counter* counter) {
+		const typename Topology::type_index* c = topo.childBegin(v);
+		std::size_t n = topo.childCount(v);
+		if(n > fanoutLimit) n = fanoutLimit;
+		for(std::size_t i = 0; i < n; ++i) write(counter + c[i]);
+		return n;
+	}
+
+	//------------------------------ array frontiers ------------------------------
+
+	// Calls visit(frontier[i]) for i in [begin,end) in order, with far(frontier[j])
+	// and near(frontier[j]) issued 2*dist and dist parents ahead (see above).
+	// far and near return the number of prefetches they issued.
+	// POST:	returns the number of prefetches issued
+	template <typename Index, typename Far, typename Near, typename Visit>
+	inline std::size_t forEach(const Index* frontier, std::size_t begin, std::size_t end, std::size_t dist,
+		Far far, Near near, Visit visit) {
+
+		if(dist == 0) {
+			for(std::size_t i = begin; i < end; ++i) visit(frontier[i]);
+			return 0;
+		}
+		std::size_t issued = 0;
+		// prologue: the first two groups
+		for(std::size_t j = begin; j < end && j < begin + 2 * dist; ++j) issued += far(frontier[j]);
+		for(std::size_t j = begin; j < end && j < begin + dist; ++j) issued += near(frontier[j]);
+		for(std::size_t group = begin; group < end; group += dist) {
+			const std::size_t groupEnd = group + dist < end ? group + dist : end;
+			for(std::size_t j = groupEnd; j < end && j < groupEnd + dist; ++j) issued += near(frontier[j]);
+			for(std::size_t j = groupEnd + dist; j < end && j < groupEnd + 2 * dist; ++j) issued += far(frontier[j]);
+			for(std::size_t i = group; i < groupEnd; ++i) visit(frontier[i]);
+		}
+		return issued;
+	}
+
+	//------------------------------ list frontiers ------------------------------
+
+	// The same two stages for a queue that is consumed at the front and grows
+	// at the back (std::list frontiers of the Node engines). Per stage it keeps
+	// the last element that was prefetched, list iterators stay valid while
+	// the elements behind them are popped and appended.
+	template <typename List>
+	class listPipeline {
+
+		public:
+
+			explicit listPipeline(std::size_t dist)
+				:	dist_(dist)
+			{}
+
+			// Call before the front is processed.
+			// POST:	the next dist elements went through near, the next 2*dist through far,
+			//			returns the number of prefetches issued
+			template <typename Far, typename Near>
+			inline std::size_t advance(List& list, Far far, Near near) {
+				if(dist_ == 0) return 0;
+				return far_.fill(list, 2 * dist_, far) + near_.fill(list, dist_, near);
+			}
+
+			// POST:	the front of the list was removed (processed)
+			inline void pop() {
+				far_.pop();
+				near_.pop();
+			}
+
+			// POST:	the list was emptied or replaced behind the back of the pipeline
+			inline void reset() {
+				far_.count_ = 0;
+				near_.count_ = 0;
+			}
+
+		private:
+
+			struct stage {
+				typename List::iterator last_;	// last element prefetched, valid if count_ > 0
+				std::size_t count_ = 0;			// elements from the front up to last_
+
+				template <typename F>
+				inline std::size_t fill(List& list, std::size_t window, F f) {
+					std::size_t issued = 0;
+					while(count_ < window) {
+						typename List::iterator next = count_ == 0 ? list.begin() : std::next(last_);
+						if(next == list.end()) break;
+						issued += f(*next);
+						last_ = next;
+						++count_;
+					}
+					return issued;
+				}
+				inline void pop() {
+					if(count_ > 0) --count_;
+				}
+			};
+
+			const std::size_t dist_;
+			stage far_;
+			stage near_;
+	};
+
+} // end namespace prefetch
+
+#endif // PREFETCH_HPP
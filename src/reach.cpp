@@ -0,0 +1,120 @@
+#include "reach.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <omp.h>
+
+namespace reach {
+
+	// frontiers below this size are expanded by the calling thread alone
+	static const std::size_t parallelGrain = 4096;
+
+	// Calls visit(v, out) for every v of the frontier, the nodes visit appends
+	// to out end up in next. Wide frontiers are split among the threads.
+	template <typename F>
+	static void expand(const std::vector<type_index>& frontier, std::vector<type_index>& next, F visit) {
+		const std::size_t n = frontier.size();
+		if(n < parallelGrain || omp_get_max_threads() == 1) {
+			for(std::size_t i = 0; i < n; ++i) visit(frontier[i], next);
+			return;
+		}
+		#pragma omp parallel
+		{
+			std::vector<type_index> next_local;
+			#pragma omp for schedule(dynamic, 256) nowait
+			for(std::size_t i = 0; i < n; ++i) {
+				visit(frontier[i], next_local);
+			}
+			#pragma omp critical
+			next.insert(next.end(), next_local.begin(), next_local.end());
+		} // end of OMP parallel
+	}
+
+	sorter::sorter(const topology& topo, const topology* reverse)
+		: topo_(topo)
+		, reverse_(reverse)
+		, stamp_(topo.size(), 0)
+		, epoch_(0)
+		, indegree_(topo.size())
+	{}
+
+	bool sorter::mark(type_index v) {
+		unsigned s = stamp_[v];
+		while(s != epoch_) {
+			const unsigned seen = __sync_val_compare_and_swap(&stamp_[v], s, epoch_);
+			if(seen == s) return true;
+			s = seen;
+		}
+		return false;
+	}
+
+	type_index sorter::sort(const std::vector<type_index>& seeds, direction dir,
+		std::vector<type_index>& order, std::vector<type_index>& levels) {
+
+		order.clear();
+		levels.clear();
+		if(dir == UPSTREAM && reverse_ == nullptr) {
+			std::cerr << "ERROR:\treach::sorter needs the transposed topology for upstream queries\n";
+			return 0;
+		}
+		if(++epoch_ == 0) { // wrapped, old marks could collide
+			std::fill(stamp_.begin(), stamp_.end(), 0);
+			epoch_ = 1;
+		}
+		const topology& walk = dir == UPSTREAM ? *reverse_ : topo_;
+
+		// 1. mark the region
+		std::vector<type_index> region;
+		std::vector<type_index> frontier;
+		std::vector<type_index> next;
+		for(type_index s : seeds) {
+			if(mark(s)) frontier.push_back(s);
+		}
+		while(!frontier.empty()) {
+			region.insert(region.end(), frontier.begin(), frontier.end());
+			expand(frontier, next, [this, &walk](type_index v, std::vector<type_index>& out) {
+				for(const type_index* c = walk.childBegin(v); c != walk.childEnd(v); ++c) {
+					if(mark(*c)) out.push_back(*c);
+				}
+			});
+			frontier.swap(next);
+			next.clear();
+		}
+
+		// 2. in-degrees from the edges inside the region
+		const std::size_t n = region.size();
+		#pragma omp parallel for schedule(static) if(n >= parallelGrain)
+		for(std::size_t i = 0; i < n; ++i) {
+			indegree_[region[i]] = 0;
+		}
+		#pragma omp parallel for schedule(dynamic, 256) if(n >= parallelGrain)
+		for(std::size_t i = 0; i < n; ++i) {
+			const type_index v = region[i];
+			for(const type_index* c = topo_.childBegin(v); c != topo_.childEnd(v); ++c) {
+				if(marked(*c)) __sync_fetch_and_add(&indegree_[*c], 1);
+			}
+		}
+
+		// 3. level by level sort of the region
+		for(type_index v : region) {
+			if(indegree_[v] == 0) frontier.push_back(v);
+		}
+		order.reserve(n);
+		levels.reserve(n);
+		type_index depth = 0;
+		while(!frontier.empty()) {
+			order.insert(order.end(), frontier.begin(), frontier.end());
+			levels.insert(levels.end(), frontier.size(), depth);
+			expand(frontier, next, [this](type_index v, std::vector<type_index>& out) {
+				for(const type_index* c = topo_.childBegin(v); c != topo_.childEnd(v); ++c) {
+					if(marked(*c) && __sync_sub_and_fetch(&indegree_[*c], 1) == 0) out.push_back(*c);
+				}
+			});
+			frontier.swap(next);
+			next.clear();
+			++depth;
+		}
+		return depth;
+	}
+
+} // end namespace reach
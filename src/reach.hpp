@@ -0,0 +1,55 @@
+#ifndef REACH_HPP
+#define REACH_HPP
+
+#include <vector>
+
+#include "topology.hpp"
+
+// Partial sorts: only the nodes reachable from a set of seeds are sorted.
+//
+// "Everything downstream of the changed nodes, in order" without sorting the
+// whole graph. The reachable region is marked by a level-synchronous
+// traversal, the in-degrees count only the edges inside the region and the
+// region is sorted level by level. Marks and counters live in a workspace
+// that is allocated once per topology and invalidated by an epoch counter,
+// so a query costs time in the size of its region, not in N.
+namespace reach {
+
+	using type_index = topology::type_index;
+
+	enum direction {DOWNSTREAM, UPSTREAM}; // descendants or ancestors of the seeds
+
+	class sorter {
+
+		public:
+
+			// reverse is the transposed topology, only needed for UPSTREAM queries
+			explicit sorter(const topology& topo, const topology* reverse = nullptr);
+
+			// Not thread safe, concurrent queries need a sorter each.
+			// PRE:		seeds < N, reverse given for UPSTREAM
+			// POST:	order holds the seeds and all nodes reachable from them in dir (each once)
+			//			in topological order of topo, grouped by level; levels[i] is the level of
+			//			order[i] within the region. Returns the number of levels.
+			type_index sort(const std::vector<type_index>& seeds, direction dir,
+				std::vector<type_index>& order, std::vector<type_index>& levels);
+
+		private:
+
+			// POST:	v is marked for the current query, returns false if it already was
+			bool mark(type_index v);
+
+			inline bool marked(type_index v) const {
+				return stamp_[v] == epoch_;
+			}
+
+			const topology& topo_;
+			const topology* reverse_;
+			std::vector<unsigned> stamp_;	// epoch_ marks the region of the current query
+			unsigned epoch_;
+			std::vector<type_index> indegree_;	// valid for marked nodes only
+	};
+
+} // end namespace reach
+
+#endif // REACH_HPP
@@ -0,0 +1,47 @@
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <omp.h>
+
+// Prefix sums for the CSR engines (chains, components)
+namespace scan {
+
+	// Exclusive prefix sum in the calling OpenMP team, every thread scans one block.
+	// PRE:		called by all threads of the team, sums has omp_get_num_threads()+1 entries
+	// POST:	v[i] is the sum of the old v[0,i), returns the total
+	template <typename T>
+	T exclusive(std::vector<T>& v, std::vector<T>& sums) {
+		const std::size_t n = v.size();
+		const int tid = omp_get_thread_num();
+		const int team = omp_get_num_threads();
+		const std::size_t first = n / team * tid + std::min<std::size_t>(tid, n % team);
+		const std::size_t last = first + n / team + (std::size_t(tid) < n % team ? 1 : 0);
+
+		T local = 0;
+		for(std::size_t i = first; i < last; ++i) local += v[i];
+		sums[tid + 1] = local;
+		#pragma omp barrier
+
+		#pragma omp single
+		{
+			sums[0] = 0;
+			for(int t = 0; t < team; ++t) sums[t + 1] += sums[t];
+		} // implicit barrier
+
+		T running = sums[tid];
+		for(std::size_t i = first; i < last; ++i) {
+			const T x = v[i];
+			v[i] = running;
+			running += x;
+		}
+		const T total = sums[team];
+		#pragma omp barrier
+		return total;
+	}
+
+} // end namespace scan
+
+#endif // SCAN_HPP
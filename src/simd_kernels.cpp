@@ -0,0 +1,189 @@
+#include "simd_kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+namespace kernels {
+
+	//------------------------------- scalar ----------------------------------
+
+	template <typename Index>
+	static std::size_t findSourcesScalar(const Index* indegree, Index begin, Index end, Index* out) {
+		std::size_t n = 0;
+		for(Index v = begin; v < end; ++v) {
+			out[n] = v;
+			n += (indegree[v] == 0); // branch free, the store is overwritten if not a source
+		}
+		return n;
+	}
+
+	template <typename Index>
+	static void countIndegreesScalar(const Index* targets, std::size_t m, Index* indegree) {
+		for(std::size_t e = 0; e < m; ++e) ++indegree[targets[e]];
+	}
+
+	template <typename Index>
+	static std::size_t decrementBatchScalar(Index* indegree, const Index* children, std::size_t n, Index* ready) {
+		std::size_t nReady = 0;
+		for(std::size_t i = 0; i < n; ++i) {
+			if(--indegree[children[i]] == 0) ready[nReady++] = children[i];
+		}
+		return nReady;
+	}
+
+	//-------------------------------- AVX2 -----------------------------------
+
+	__attribute__((target("avx2")))
+	static std::size_t findSourcesAvx2(const type_index* indegree, type_index begin, type_index end, type_index* out) {
+		std::size_t n = 0;
+		type_index v = begin;
+		const __m256i zero = _mm256_setzero_si256();
+		for(; v + 8 <= end; v += 8) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indegree + v));
+			unsigned bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, zero)));
+			while(bits) {
+				out[n++] = v + __builtin_ctz(bits);
+				bits &= bits - 1;
+			}
+		}
+		return n + findSourcesScalar(indegree, v, end, out + n);
+	}
+
+	//------------------------------- AVX-512 ---------------------------------
+
+	__attribute__((target("avx512f")))
+	static std::size_t findSourcesAvx512(const type_index* indegree, type_index begin, type_index end, type_index* out) {
+		std::size_t n = 0;
+		type_index v = begin;
+		const __m512i zero = _mm512_setzero_si512();
+		const __m512i iota = _mm512_setr_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+		for(; v + 16 <= end; v += 16) {
+			__m512i x = _mm512_loadu_si512(indegree + v);
+			__mmask16 m = _mm512_cmpeq_epi32_mask(x, zero);
+			if(m) {
+				__m512i ids = _mm512_add_epi32(_mm512_set1_epi32(v), iota);
+				_mm512_mask_compressstoreu_epi32(out + n, m, ids);
+				n += __builtin_popcount(m);
+			}
+		}
+		return n + findSourcesScalar(indegree, v, end, out + n);
+	}
+
+	// PRE:		active lanes of idx
+	// POST:	returns the active lanes whose value does not occur in an earlier active lane,
+	//			i.e. one lane per distinct value
+	__attribute__((target("avx512f,avx512cd")))
+	static inline __mmask16 firstOccurrences(__m512i idx, __mmask16 active) {
+		__m512i conf = _mm512_conflict_epi32(idx); // bit j of lane i: lane j < i holds the same value
+		__m512i act = _mm512_set1_epi32(active);
+		return _mm512_mask_testn_epi32_mask(active, conf, act);
+	}
+
+	__attribute__((target("avx512f,avx512cd")))
+	static void countIndegreesAvx512(const type_index* targets, std::size_t m, type_index* indegree) {
+		std::size_t e = 0;
+		const __m512i one = _mm512_set1_epi32(1);
+		int* base = reinterpret_cast<int*>(indegree);
+		for(; e + 16 <= m; e += 16) {
+			__m512i idx = _mm512_loadu_si512(targets + e);
+			__mmask16 active = 0xFFFF;
+			while(active) { // one round per multiplicity, usually one
+				__mmask16 todo = firstOccurrences(idx, active);
+				__m512i cnt = _mm512_mask_i32gather_epi32(one, todo, idx, base, 4);
+				_mm512_mask_i32scatter_epi32(base, todo, idx, _mm512_add_epi32(cnt, one), 4);
+				active &= ~todo;
+			}
+		}
+		countIndegreesScalar(targets + e, m - e, indegree);
+	}
+
+	__attribute__((target("avx512f,avx512cd")))
+	static std::size_t decrementBatchAvx512(type_index* indegree, const type_index* children, std::size_t n, type_index* ready) {
+		std::size_t i = 0;
+		std::size_t nReady = 0;
+		const __m512i one = _mm512_set1_epi32(1);
+		const __m512i zero = _mm512_setzero_si512();
+		int* base = reinterpret_cast<int*>(indegree);
+		for(; i + 16 <= n; i += 16) {
+			__m512i idx = _mm512_loadu_si512(children + i);
+			__mmask16 active = 0xFFFF;
+			while(active) {
+				__mmask16 todo = firstOccurrences(idx, active);
+				__m512i cnt = _mm512_mask_i32gather_epi32(one, todo, idx, base, 4);
+				cnt = _mm512_sub_epi32(cnt, one);
+				_mm512_mask_i32scatter_epi32(base, todo, idx, cnt, 4);
+				__mmask16 done = _mm512_mask_cmpeq_epi32_mask(todo, cnt, zero);
+				_mm512_mask_compressstoreu_epi32(ready + nReady, done, idx);
+				nReady += __builtin_popcount(done);
+				active &= ~todo;
+			}
+		}
+		return nReady + decrementBatchScalar(indegree, children + i, n - i, ready + nReady);
+	}
+
+	//------------------------------- dispatch --------------------------------
+
+	static isa detect() {
+		isa best = SCALAR;
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2")) best = AVX2;
+		if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")) best = AVX512;
+
+		const char* env = std::getenv("TOPOSORT_SIMD");
+		if(env) {
+			isa requested = best;
+			if(std::strcmp(env, "scalar") == 0) requested = SCALAR;
+			else if(std::strcmp(env, "avx2") == 0) requested = AVX2;
+			else if(std::strcmp(env, "avx512") == 0) requested = AVX512;
+			if(requested < best) best = requested;
+		}
+		return best;
+	}
+
+	isa active() {
+		static const isa selected = detect();
+		return selected;
+	}
+
+	const char* isaName(isa i) {
+		static const char* names[N_ISA] = {"scalar", "avx2", "avx512"};
+		return names[i];
+	}
+
+	// gathers and scatters take signed 32 bit indices
+	static inline bool indexable(type_index N) {
+		return N < (type_index(1) << 31);
+	}
+
+	std::size_t findSources(const type_index* indegree, type_index begin, type_index end, type_index* out) {
+		switch(active()) {
+			case AVX512:	return findSourcesAvx512(indegree, begin, end, out);
+			case AVX2:		return findSourcesAvx2(indegree, begin, end, out);
+			default:		return findSourcesScalar(indegree, begin, end, out);
+		}
+	}
+
+	void countIndegrees(const type_index* targets, std::size_t m, type_index* indegree, type_index N) {
+		if(active() == AVX512 && indexable(N)) countIndegreesAvx512(targets, m, indegree);
+		else countIndegreesScalar(targets, m, indegree);
+	}
+
+	std::size_t decrementBatch(type_index* indegree, const type_index* children, std::size_t n, type_index* ready, type_index N) {
+		if(active() == AVX512 && indexable(N)) return decrementBatchAvx512(indegree, children, n, ready);
+		return decrementBatchScalar(indegree, children, n, ready);
+	}
+
+	std::size_t findSources(const std::uint64_t* indegree, std::uint64_t begin, std::uint64_t end, std::uint64_t* out) {
+		return findSourcesScalar(indegree, begin, end, out);
+	}
+
+	void countIndegrees(const std::uint64_t* targets, std::size_t m, std::uint64_t* indegree, std::uint64_t) {
+		countIndegreesScalar(targets, m, indegree);
+	}
+
+	std::size_t decrementBatch(std::uint64_t* indegree, const std::uint64_t* children, std::size_t n, std::uint64_t* ready, std::uint64_t) {
+		return decrementBatchScalar(indegree, children, n, ready);
+	}
+
+} // end namespace kernels
@@ -0,0 +1,49 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized kernels on flat in-degree arrays (topology, sortState).
+//
+// Every kernel exists as scalar code and, where the instruction set helps, as
+// AVX2 and AVX-512 (F + CD) code. The variant is chosen once at run time from
+// the CPU features; TOPOSORT_SIMD=scalar|avx2|avx512 selects a lower one.
+// AVX2 has no scatter and no conflict detection, so it only speeds up the
+// source scan. Gathers and scatters use 32 bit signed indices, arrays with
+// 2^31 or more entries always take the scalar code, as do 64 bit ids (the
+// overloads at the end).
+namespace kernels {
+
+	using type_index = std::uint32_t;
+
+	enum isa {SCALAR, AVX2, AVX512, N_ISA};
+
+	// POST:	returns the instruction set the kernels use
+	isa active();
+	const char* isaName(isa i);
+
+	// POST:	the ids v in [begin,end) with indegree[v] == 0 are written to out in
+	//			increasing order, returns their number (out needs end-begin entries)
+	std::size_t findSources(const type_index* indegree, type_index begin, type_index end, type_index* out);
+
+	// Histogram of the targets, not atomic
+	// PRE:		all targets < N, indegree has N entries
+	// POST:	indegree[t] is incremented once per occurrence of t in targets[0,m)
+	void countIndegrees(const type_index* targets, std::size_t m, type_index* indegree, type_index N);
+
+	// Gather, decrement and scatter of a batch of children, not atomic.
+	// A child that occurs several times in the batch is decremented as often.
+	// PRE:		all children < N, their counters are larger than their number of occurrences - 1
+	// POST:	the children whose counter reached zero are written to ready (each once),
+	//			returns their number
+	std::size_t decrementBatch(type_index* indegree, const type_index* children, std::size_t n, type_index* ready, type_index N);
+
+	// 64 bit ids, scalar
+	std::size_t findSources(const std::uint64_t* indegree, std::uint64_t begin, std::uint64_t end, std::uint64_t* out);
+	void countIndegrees(const std::uint64_t* targets, std::size_t m, std::uint64_t* indegree, std::uint64_t N);
+	std::size_t decrementBatch(std::uint64_t* indegree, const std::uint64_t* children, std::size_t n, std::uint64_t* ready, std::uint64_t N);
+
+} // end namespace kernels
+
+#endif // SIMD_KERNELS_HPP
@@ -0,0 +1,146 @@
+#include "sink.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <omp.h>
+
+namespace sink {
+
+	static void ioFailure(const char* what, const std::string& target) {
+		std::cerr << "\nERROR:\tsink could not " << what << " " << target << ": " << std::strerror(errno) << std::endl;
+	}
+
+	// POST:	all n bytes of data are written to fd, returns false on error
+	static bool writeAll(int fd, const char* data, std::size_t n) {
+		while(n > 0) {
+			const ssize_t w = ::write(fd, data, n);
+			if(w < 0) {
+				if(errno == EINTR) continue;
+				return false;
+			}
+			data += w;
+			n -= w;
+		}
+		return true;
+	}
+
+	//------------------------------ fileWriter ------------------------------
+
+	template <typename Index>
+	basic_fileWriter<Index>::basic_fileWriter(const std::string& path, std::size_t bufferSize)
+		: fd_(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644))
+		, buffer_(bufferSize > 0 ? bufferSize : defaultBuffer)
+		, used_(0)
+		, bytes_(0)
+		, seconds_(0)
+	{
+		if(fd_ < 0) ioFailure("open", path);
+	}
+
+	template <typename Index>
+	basic_fileWriter<Index>::~basic_fileWriter() {
+		close();
+	}
+
+	template <typename Index>
+	bool basic_fileWriter<Index>::flush() {
+		if(used_ == 0) return true;
+		const double start = omp_get_wtime();
+		const bool ok = writeAll(fd_, buffer_.data(), used_);
+		seconds_ += omp_get_wtime() - start;
+		if(!ok) ioFailure("write", "output file");
+		bytes_ += used_;
+		used_ = 0;
+		return ok;
+	}
+
+	template <typename Index>
+	bool basic_fileWriter<Index>::append(const void* data, std::size_t n) {
+		if(used_ + n > buffer_.size() && !flush()) return false;
+		if(n > buffer_.size()) { // larger than the buffer, straight from the caller
+			const double start = omp_get_wtime();
+			const bool ok = writeAll(fd_, static_cast<const char*>(data), n);
+			seconds_ += omp_get_wtime() - start;
+			if(!ok) ioFailure("write", "output file");
+			bytes_ += n;
+			return ok;
+		}
+		std::memcpy(buffer_.data() + used_, data, n);
+		used_ += n;
+		return true;
+	}
+
+	template <typename Index>
+	bool basic_fileWriter<Index>::level(Index level, const Index* nodes, std::size_t n) {
+		if(fd_ < 0) return false;
+		const std::uint64_t header[2] = {level, n};
+		return append(header, sizeof(header)) && append(nodes, n * sizeof(Index));
+	}
+
+	template <typename Index>
+	bool basic_fileWriter<Index>::close() {
+		if(fd_ < 0) return false;
+		bool ok = flush();
+		if(::close(fd_) != 0) {
+			ioFailure("close", "output file");
+			ok = false;
+		}
+		fd_ = -1;
+		return ok;
+	}
+
+	//------------------------------ pipeWriter ------------------------------
+
+	template <typename Index>
+	basic_pipeWriter<Index>::basic_pipeWriter(int fd)
+		: fd_(fd)
+		, bytes_(0)
+		, seconds_(0)
+	{}
+
+	template <typename Index>
+	bool basic_pipeWriter<Index>::level(Index level, const Index* nodes, std::size_t n) {
+		const std::uint64_t header[2] = {level, n};
+		iovec iov[2];
+		iov[0].iov_base = const_cast<std::uint64_t*>(header);
+		iov[0].iov_len = sizeof(header);
+		iov[1].iov_base = const_cast<Index*>(nodes);
+		iov[1].iov_len = n * sizeof(Index);
+
+		const double start = omp_get_wtime();
+		iovec* next = iov;
+		int count = n > 0 ? 2 : 1;
+		while(count > 0) {
+			ssize_t w = ::writev(fd_, next, count);
+			if(w < 0) {
+				if(errno == EINTR) continue;
+				seconds_ += omp_get_wtime() - start;
+				ioFailure("write", "descriptor " + std::to_string(fd_));
+				return false;
+			}
+			bytes_ += w;
+			// a pipe may take less than asked for, continue behind the written part
+			while(count > 0 && static_cast<std::size_t>(w) >= next->iov_len) {
+				w -= next->iov_len;
+				++next;
+				--count;
+			}
+			if(count > 0) {
+				next->iov_base = static_cast<char*>(next->iov_base) + w;
+				next->iov_len -= w;
+			}
+		}
+		seconds_ += omp_get_wtime() - start;
+		return true;
+	}
+
+	template class basic_fileWriter<std::uint32_t>;
+	template class basic_fileWriter<std::uint64_t>;
+	template class basic_pipeWriter<std::uint32_t>;
+	template class basic_pipeWriter<std::uint64_t>;
+
+} // end namespace sink
@@ -0,0 +1,140 @@
+#ifndef SINK_HPP
+#define SINK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Receivers of the order while a level-synchronous sort runs (csrsort::levels).
+//
+// A level is handed over as soon as all its nodes are placed, in level order
+// and by one thread at a time, while the other threads already expand the
+// next level. The ids point into the order of the sort, they stay valid and
+// unchanged after the call. A consumer can start on the first levels long
+// before the sort ends, and the writers below never copy the whole order.
+//
+// Stream format of the writers, native byte order, per level:
+//   uint64 level, uint64 count, count ids of sizeof(Index) bytes
+namespace sink {
+
+	template <typename Index>
+	class basic_levelSink {
+
+		public:
+
+			virtual ~basic_levelSink() {}
+
+			// PRE:		called for level 0, 1, 2, ... one call at a time
+			// POST:	returns false on error, the sort then stops calling
+			virtual bool level(Index level, const Index* nodes, std::size_t n) = 0;
+
+			// POST:	everything received is delivered, returns false on error
+			virtual bool close() {
+				return true;
+			}
+	};
+
+	// Buffered binary file, one write() per full buffer. Levels larger than the
+	// buffer are written from the order directly.
+	template <typename Index>
+	class basic_fileWriter : public basic_levelSink<Index> {
+
+		public:
+
+			static const std::size_t defaultBuffer = std::size_t(1) << 20;
+
+			// POST:	path is created or truncated, good() is false if it cannot be opened
+			explicit basic_fileWriter(const std::string& path, std::size_t bufferSize = defaultBuffer);
+			~basic_fileWriter();
+
+			bool level(Index level, const Index* nodes, std::size_t n) override;
+			bool close() override;
+
+			inline bool good() const {
+				return fd_ >= 0;
+			}
+			inline std::uint64_t bytes() const {
+				return bytes_;
+			}
+			// time spent in write()
+			inline double seconds() const {
+				return seconds_;
+			}
+
+		private:
+
+			bool flush();
+			bool append(const void* data, std::size_t n);
+
+			int fd_;
+			std::vector<char> buffer_;
+			std::size_t used_;
+			std::uint64_t bytes_;
+			double seconds_;
+	};
+
+	// Unbuffered writer on a descriptor (pipe, socket, stdout): one writev()
+	// per level, header and ids straight from the order. The descriptor is not closed.
+	template <typename Index>
+	class basic_pipeWriter : public basic_levelSink<Index> {
+
+		public:
+
+			explicit basic_pipeWriter(int fd);
+
+			bool level(Index level, const Index* nodes, std::size_t n) override;
+
+			inline std::uint64_t bytes() const {
+				return bytes_;
+			}
+			// time spent in writev()
+			inline double seconds() const {
+				return seconds_;
+			}
+
+		private:
+
+			int fd_;
+			std::uint64_t bytes_;
+			double seconds_;
+	};
+
+	// Hands every level to two sinks (either may be null)
+	template <typename Index>
+	class basic_tee : public basic_levelSink<Index> {
+
+		public:
+
+			basic_tee(basic_levelSink<Index>* first, basic_levelSink<Index>* second)
+				:	first_(first)
+				,	second_(second)
+			{}
+
+			bool level(Index level, const Index* nodes, std::size_t n) override {
+				const bool ok = !first_ || first_->level(level, nodes, n);
+				return (!second_ || second_->level(level, nodes, n)) && ok;
+			}
+			bool close() override {
+				const bool ok = !first_ || first_->close();
+				return (!second_ || second_->close()) && ok;
+			}
+
+		private:
+
+			basic_levelSink<Index>* first_;
+			basic_levelSink<Index>* second_;
+	};
+
+	// 32 bit ids (topology, topology32) and 64 bit ids (topology64), instantiated in sink.cpp
+	using levelSink = basic_levelSink<std::uint32_t>;
+	using fileWriter = basic_fileWriter<std::uint32_t>;
+	using pipeWriter = basic_pipeWriter<std::uint32_t>;
+	using tee = basic_tee<std::uint32_t>;
+	using levelSink64 = basic_levelSink<std::uint64_t>;
+	using fileWriter64 = basic_fileWriter<std::uint64_t>;
+	using pipeWriter64 = basic_pipeWriter<std::uint64_t>;
+
+} // end namespace sink
+
+#endif // SINK_HPP
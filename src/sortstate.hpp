@@ -0,0 +1,114 @@
+#ifndef SORTSTATE_HPP
+#define SORTSTATE_HPP
+
+#include <vector>
+
+#include "topology.hpp"
+
+// Everything a sort of a topology writes: the remaining in-degrees, the level
+// of every node and the output order. The topology itself stays untouched, so
+// a state can be reset and the graph sorted again, and concurrent sorts of one
+// topology each use their own state.
+template <typename Topology>
+class basic_sortState {
+
+	public:
+
+		using type_topology = Topology;
+		using type_index = typename Topology::type_index;
+
+		// POST:	the state is reset
+		explicit basic_sortState(const Topology& topo);
+
+		// POST:	in-degrees are the initial ones (one parallel copy), levels are 0, the order is empty
+		void reset();
+
+		inline const Topology& getTopology() const {
+			return topo_;
+		}
+
+		// Atomic decrement of the in-degree of v
+		// POST:	returns true for exactly one caller, the one that removed the last parent
+		inline bool decrement(type_index v) {
+			return __sync_sub_and_fetch(&indegree_[v], 1) == 0;
+		}
+
+		// Same as decrement, for sorts with a single thread
+		inline bool decrementSerial(type_index v) {
+			return --indegree_[v] == 0;
+		}
+
+		inline type_index indegree(type_index v) const {
+			return indegree_[v];
+		}
+
+		inline void setLevel(type_index v, type_index level) {
+			level_[v] = level;
+		}
+
+		// Atomic maximum, for sorts that release a node before all its parents are placed
+		inline void raiseLevel(type_index v, type_index level) {
+			type_index old = level_[v];
+			while(old < level) {
+				const type_index seen = __sync_val_compare_and_swap(&level_[v], old, level);
+				if(seen == old) return;
+				old = seen;
+			}
+		}
+
+		inline type_index level(type_index v) const {
+			return level_[v];
+		}
+
+		// Atomically reserves n consecutive slots at the end of the order
+		// POST:	returns the index of the first slot
+		inline type_index reserve(type_index n) {
+			return __sync_fetch_and_add(&nOrdered_, n);
+		}
+
+		inline void put(type_index slot, type_index v) {
+			order_[slot] = v;
+		}
+
+		// number of nodes in the order so far
+		inline type_index size() const {
+			return nOrdered_;
+		}
+
+		inline const std::vector<type_index>& order() const {
+			return order_;
+		}
+
+		inline const std::vector<type_index>& levels() const {
+			return level_;
+		}
+
+		// Raw access for the engines, the order is written through reserve/put
+		inline type_index* orderData() {
+			return order_.data();
+		}
+
+		// Raw access for the vector kernels, not atomic
+		inline type_index* indegreeData() {
+			return indegree_.data();
+		}
+
+		// bytes of the in-degree counters, levels and order
+		inline std::size_t bytes() const {
+			return (indegree_.capacity() + level_.capacity() + order_.capacity()) * sizeof(type_index);
+		}
+
+	private:
+
+		const Topology& topo_;
+		std::vector<type_index> indegree_;
+		std::vector<type_index> level_;
+		std::vector<type_index> order_;
+		type_index nOrdered_;
+};
+
+using sortState = basic_sortState<topology>;
+using sortState32 = basic_sortState<topology32>;
+using sortState64 = basic_sortState<topology64>;
+
+#endif // SORTSTATE_HPP
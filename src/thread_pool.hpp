@@ -0,0 +1,168 @@
+// File:    thread_pool.hpp
+// Persistent, pinned worker threads with low-latency job dispatch and barrier
+
+#ifndef UTIL_THREAD_POOL_HEADER
+#define UTIL_THREAD_POOL_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sched.h>
+
+namespace util {
+
+    namespace detail {
+        inline void cpu_relax() {
+            #if defined(__x86_64__) || defined(__i386__)
+            asm volatile ("pause" ::: "memory");
+            #elif defined(__aarch64__)
+            asm volatile ("yield" ::: "memory");
+            #else
+            asm volatile ("" ::: "memory");
+            #endif
+        }
+    }// end namespace detail
+
+    // The calling thread runs as thread 0 of every job, size()-1 workers are
+    // started once and stay alive. Idle workers spin for a while before they
+    // sleep on a condition variable, so back-to-back jobs (and barriers) do
+    // not pay for a kernel wake-up. With more threads than processors waiting
+    // threads yield right away, spinning would only delay the thread waited for.
+    class thread_pool {
+    public:
+        static const unsigned spin_iterations = 1 << 14;
+
+        explicit thread_pool(int n_threads)
+            : size_(n_threads > 0 ? n_threads : 1)
+            , job_(nullptr)
+            , generation_(0)
+            , pending_(0)
+            , sleeping_(0)
+            , stop_(false)
+            , barrier_count_(0)
+            , barrier_generation_(0)
+        {
+            const unsigned n_procs = std::thread::hardware_concurrency();
+            spin_ = (n_procs > 0 && static_cast<unsigned>(size_) > n_procs) ? 0 : spin_iterations;
+            for(int tid = 1; tid < size_; ++tid) {
+                workers_.emplace_back(&thread_pool::worker_loop, this, tid);
+                if(n_procs > 0) { // pin worker tid to processor tid (round robin)
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(tid % n_procs, &set);
+                    pthread_setaffinity_np(workers_.back().native_handle(), sizeof(set), &set);
+                }
+            }
+        }
+        ~thread_pool() {
+            stop_.store(true);
+            generation_.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+            }
+            cv_.notify_all();
+            for(auto & w : workers_) w.join();
+        }
+        thread_pool(thread_pool const &) = delete;
+        thread_pool& operator=(thread_pool const &) = delete;
+
+        // Pool shared by all engines of the process. A call with another size
+        // stops the workers and starts a pool of n_threads.
+        // PRE:  not called from inside a job, no reference to the old pool is used afterwards
+        static thread_pool& instance(int n_threads) {
+            std::unique_ptr<thread_pool>& pool = shared();
+            if(n_threads < 1) n_threads = 1;
+            if(!pool || pool->size() != n_threads) {
+                pool.reset(); // join the old workers before pinning new ones
+                pool.reset(new thread_pool(n_threads));
+            }
+            return *pool;
+        }
+        // PRE:  instance() was called, e.g. from inside a job (workers must not resize the pool)
+        // POST: returns the pool of the last instance() call
+        static thread_pool& current() {
+            return *shared();
+        }
+
+        //--------------------------- methods ----------------------------------
+        // PRE:  not called from inside a job
+        // POST: job(tid) has returned on all threads 0..size()-1
+        void run(std::function<void(int)> const & job) {
+            job_ = &job;
+            pending_.store(size_ - 1);
+            generation_.fetch_add(1); // seq_cst: pairs with sleeping_ in worker_loop
+            if(sleeping_.load() > 0) {
+                { std::lock_guard<std::mutex> lock(mutex_); }
+                cv_.notify_all();
+            }
+            job(0);
+            for(unsigned i = 0; pending_.load(std::memory_order_acquire) != 0; ++i) {
+                if(i < spin_) detail::cpu_relax();
+                else std::this_thread::yield();
+            }
+        }
+        // PRE:  called by all threads of the running job
+        void barrier() {
+            const unsigned gen = barrier_generation_.load(std::memory_order_acquire);
+            if(barrier_count_.fetch_add(1, std::memory_order_acq_rel) == size_ - 1) {
+                barrier_count_.store(0, std::memory_order_relaxed);
+                barrier_generation_.fetch_add(1, std::memory_order_release);
+                return;
+            }
+            for(unsigned i = 0; barrier_generation_.load(std::memory_order_acquire) == gen; ++i) {
+                if(i < spin_) detail::cpu_relax();
+                else std::this_thread::yield();
+            }
+        }
+        //------------------------- const methods ------------------------------
+        int size() const {
+            return size_;
+        }
+    private:
+        static std::unique_ptr<thread_pool>& shared() {
+            static std::unique_ptr<thread_pool> pool;
+            return pool;
+        }
+
+        void worker_loop(int tid) {
+            unsigned seen = 0;
+            while(true) {
+                unsigned i = 0;
+                while(generation_.load(std::memory_order_acquire) == seen && i < spin_) {
+                    detail::cpu_relax();
+                    ++i;
+                }
+                if(generation_.load() == seen) { // nothing to do, go to sleep
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    sleeping_.fetch_add(1);
+                    cv_.wait(lock, [&]{ return generation_.load() != seen; });
+                    sleeping_.fetch_sub(1);
+                }
+                seen = generation_.load(std::memory_order_acquire);
+                if(stop_.load()) return;
+                (*job_)(tid);
+                pending_.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        const int size_;
+        unsigned spin_;                     // pause iterations before a waiting thread yields or sleeps
+        std::vector<std::thread> workers_;
+        std::function<void(int)> const * job_;
+        std::atomic<unsigned> generation_;  // incremented once per job
+        std::atomic<int> pending_;          // workers that have not finished the current job
+        std::atomic<int> sleeping_;
+        std::atomic<bool> stop_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        alignas(64) std::atomic<int> barrier_count_;
+        alignas(64) std::atomic<unsigned> barrier_generation_;
+    };
+
+} // end namespace util
+
+#endif // UTIL_THREAD_POOL_HEADER
@@ -0,0 +1,126 @@
+#include "topology.hpp"
+#include "sortstate.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <omp.h>
+
+
+template <typename Index, typename Offset>
+basic_topology<Index, Offset>::basic_topology(std::vector<type_offset> offsets, std::vector<type_index> targets)
+	: ownedOffsets_(std::move(offsets))
+	, ownedTargets_(std::move(targets))
+	, offsets_(ownedOffsets_.data())
+	, targets_(ownedTargets_.data())
+	, N_(static_cast<type_index>(ownedOffsets_.size() - 1))
+	, indegree_()
+{
+	assert(!ownedOffsets_.empty() && ownedOffsets_.front() == 0 && ownedOffsets_.back() == ownedTargets_.size());
+	countIndegrees();
+}
+
+template <typename Index, typename Offset>
+basic_topology<Index, Offset>::basic_topology(type_index N, const type_offset* offsets, const type_index* targets)
+	: ownedOffsets_()
+	, ownedTargets_()
+	, offsets_(offsets)
+	, targets_(targets)
+	, N_(N)
+	, indegree_()
+{
+	assert(offsets_[0] == 0);
+	countIndegrees();
+}
+
+template <typename Index, typename Offset>
+void basic_topology<Index, Offset>::countIndegrees() {
+	const type_index N = size();
+	const type_offset nEdges = this->nEdges();
+	const int T = omp_in_parallel() ? 1 : omp_get_max_threads(); // a nested region gets one thread
+	indegree_.assign(N, 0);
+
+	// upper bound for the private histograms of all threads
+	const std::size_t maxHistogramBytes = std::size_t(1) << 28;
+
+	if(T == 1) {
+		kernels::countIndegrees(targets_, nEdges, indegree_.data(), N);
+	} else if(std::size_t(T) * N * sizeof(type_index) <= maxHistogramBytes) {
+		// every thread counts its slice of the edges privately, then the histograms are summed up
+		std::vector<type_index> histograms(std::size_t(T) * N, 0);
+		#pragma omp parallel num_threads(T)
+		{
+			// the runtime may hand out fewer than T threads (OMP_DYNAMIC, OMP_THREAD_LIMIT)
+			const int tid = omp_get_thread_num();
+			const int team = omp_get_num_threads();
+			const type_offset first = nEdges / team * tid + std::min<type_offset>(tid, nEdges % team);
+			const type_offset last = first + nEdges / team + (type_offset(tid) < nEdges % team ? 1 : 0);
+			kernels::countIndegrees(targets_ + first, last - first, histograms.data() + std::size_t(tid) * N, N);
+			#pragma omp barrier
+
+			#pragma omp for schedule(static)
+			for(type_index v = 0; v < N; ++v) {
+				type_index sum = 0;
+				for(int t = 0; t < team; ++t) sum += histograms[std::size_t(t) * N + v];
+				indegree_[v] = sum;
+			}
+		}
+	} else {
+		#pragma omp parallel for
+		for(type_offset e = 0; e < nEdges; ++e) {
+			__sync_fetch_and_add(&indegree_[targets_[e]], 1);
+		}
+	}
+}
+
+template <typename Index, typename Offset>
+basic_topology<Index, Offset> basic_topology<Index, Offset>::transposed() const {
+	const type_index N = size();
+	std::vector<type_offset> offsets(N + 1, 0);
+	for(type_index v = 0; v < N; ++v) {
+		offsets[v+1] = offsets[v] + indegree_[v];
+	}
+	// filled per source in increasing order, so every parent list is sorted
+	std::vector<type_offset> cursor(offsets.begin(), offsets.end() - 1);
+	std::vector<type_index> parents(nEdges());
+	for(type_index v = 0; v < N; ++v) {
+		for(const type_index* c = childBegin(v); c != childEnd(v); ++c) {
+			parents[cursor[*c]++] = v;
+		}
+	}
+	return basic_topology(std::move(offsets), std::move(parents));
+}
+
+
+template <typename Topology>
+basic_sortState<Topology>::basic_sortState(const Topology& topo)
+	: topo_(topo)
+	, indegree_(topo.size())
+	, level_(topo.size())
+	, order_(topo.size())
+	, nOrdered_(0)
+{
+	reset();
+}
+
+template <typename Topology>
+void basic_sortState<Topology>::reset() {
+	const type_index N = topo_.size();
+	const type_index* init = topo_.indegrees().data();
+	#pragma omp parallel for schedule(static)
+	for(type_index v = 0; v < N; ++v) {
+		indegree_[v] = init[v];
+		level_[v] = 0;
+	}
+	nOrdered_ = 0;
+}
+
+
+template class basic_topology<Node::type_index>;
+template class basic_topology<std::uint32_t, std::uint32_t>;
+template class basic_topology<std::uint64_t>;
+
+template class basic_sortState<topology>;
+template class basic_sortState<topology32>;
+template class basic_sortState<topology64>;
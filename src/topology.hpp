@@ -0,0 +1,101 @@
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "node.hpp"
+
+// Read-only graph structure in compressed sparse row (CSR) form: the children
+// of node v are targets_[offsets_[v]] ... targets_[offsets_[v+1]-1]. Nothing
+// in here changes while sorting, so any number of sorts may share one
+// topology, each with its own sortState (sortstate.hpp).
+//
+// Index is the type of node ids, in-degrees and levels, it bounds the number
+// of nodes. Offset indexes the edges and bounds their number. The widths
+// instantiated in topology.cpp are the aliases below.
+template <typename Index, typename Offset = std::uint64_t>
+class basic_topology {
+
+	public:
+
+		using type_index = Index;
+		using type_offset = Offset;
+
+		// PRE:		offsets has N+1 entries, offsets[0] = 0, targets has offsets[N] entries < N
+		// POST:	the in-degrees are counted in parallel
+		basic_topology(std::vector<type_offset> offsets, std::vector<type_index> targets);
+
+		// View on arrays of the caller, nothing is copied
+		// PRE:		as above for the N+1 offsets and the targets, both outlive the topology
+		// POST:	the in-degrees are counted in parallel
+		basic_topology(type_index N, const type_offset* offsets, const type_index* targets);
+
+		// the arrays may be owned, a copy would point into the original
+		basic_topology(const basic_topology&) = delete;
+		basic_topology(basic_topology&&) = default;
+
+		inline type_index size() const {
+			return N_;
+		}
+
+		inline type_offset nEdges() const {
+			return offsets_[N_];
+		}
+
+		inline const type_index* childBegin(type_index v) const {
+			return targets_ + offsets_[v];
+		}
+
+		inline const type_index* childEnd(type_index v) const {
+			return targets_ + offsets_[v+1];
+		}
+
+		inline type_index childCount(type_index v) const {
+			return static_cast<type_index>(offsets_[v+1] - offsets_[v]);
+		}
+
+		// in-degree of every node before sorting, the initial state of a sortState
+		inline const std::vector<type_index>& indegrees() const {
+			return indegree_;
+		}
+
+		// POST:	returns the topology with every edge reversed, the children of v are its parents here
+		basic_topology transposed() const;
+
+		inline const type_offset* offsets() const {
+			return offsets_;
+		}
+
+		inline const type_index* targets() const {
+			return targets_;
+		}
+
+		// bytes of the offsets, targets and in-degrees, also when a view refers to arrays of the caller
+		inline std::size_t bytes() const {
+			return (static_cast<std::size_t>(N_) + 1) * sizeof(type_offset)
+				+ static_cast<std::size_t>(nEdges()) * sizeof(type_index)
+				+ indegree_.capacity() * sizeof(type_index);
+		}
+
+	private:
+
+		void countIndegrees();
+
+		std::vector<type_offset> ownedOffsets_;	// empty for a view
+		std::vector<type_index> ownedTargets_;
+		const type_offset* offsets_;
+		const type_index* targets_;
+		type_index N_;
+		std::vector<type_index> indegree_;
+};
+
+// ids of the Node graph, 64 bit edge offsets: beyond 2^32 edges
+using topology = basic_topology<Node::type_index>;
+// less than 2^32 edges, the compact layout
+using topology32 = basic_topology<std::uint32_t, std::uint32_t>;
+// beyond 2^32 nodes
+using topology64 = basic_topology<std::uint64_t>;
+
+#endif // TOPOLOGY_HPP
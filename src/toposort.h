@@ -0,0 +1,87 @@
+#ifndef TOPOSORT_H
+#define TOPOSORT_H
+
+/* C interface of libtoposort.so (make lib).
+ *
+ * The graph is passed as CSR arrays owned by the caller: the children of
+ * node v are targets[offsets[v]] ... targets[offsets[v+1]-1]. The arrays are
+ * read in place and never copied or modified, they only need to stay valid
+ * during the call. The order (and optionally the level of every node) is
+ * written to buffers of the caller.
+ *
+ * All functions are reentrant, concurrent calls on the same arrays are fine.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPOSORT_API_VERSION 2 /* 2: toposort_sort_stats */
+
+typedef enum {
+	TOPOSORT_OK = 0,
+	TOPOSORT_EINVAL = 1,	/* malformed arrays: offsets not increasing from 0, target >= n, null pointer */
+	TOPOSORT_ECYCLE = 2,	/* the graph has a cycle, order and levels are incomplete */
+	TOPOSORT_EENGINE = 3	/* unknown engine name */
+} toposort_status;
+
+/* Engines for toposort_sort:
+ *   "serial"      queue based, one thread
+ *   "levels"      level-synchronous, nThreads threads
+ *   "chains"      levels on the graph with its chains collapsed, for deep graphs
+ *   "components"  weakly connected components sorted independently
+ * NULL selects "levels". toposort_sort64 knows "serial" and "levels" only.
+ */
+
+/* What a sort did, filled by the _stats variants */
+typedef struct {
+	double seconds;			/* wall time of the sort, without the validation */
+	uint64_t nodes;			/* nodes in the order */
+	uint64_t edges;
+	uint64_t depth;			/* number of levels */
+	int threads;			/* threads of the parallel engines */
+	uint64_t super_nodes;	/* "chains": nodes of the contracted graph, else 0 */
+	uint64_t components;	/* "components": weakly connected components, else 0 */
+} toposort_stats;
+
+/* returns TOPOSORT_API_VERSION of the library */
+int toposort_api_version(void);
+
+/* returns a static description of status */
+const char* toposort_strerror(toposort_status status);
+
+/* Topological sort of n nodes with 32 bit ids and 64 bit edge offsets.
+ * offsets:   n+1 entries, offsets[0] = 0, non-decreasing
+ * targets:   offsets[n] entries < n
+ * engine:    see above, NULL for "levels"
+ * nThreads:  threads of the parallel engines, <= 0 for the OpenMP default
+ * order:     n entries, receives the nodes in topological order
+ * levels:    NULL or n entries, levels[v] = length of the longest path from a source to v
+ * depth:     NULL or receives the number of levels
+ * With validate != 0 the arrays are checked first (one parallel pass over them).
+ */
+toposort_status toposort_sort(uint32_t n, const uint64_t* offsets, const uint32_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint32_t* order, uint32_t* levels, uint32_t* depth);
+
+/* The same for graphs with 2^32 nodes or more */
+toposort_status toposort_sort64(uint64_t n, const uint64_t* offsets, const uint64_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint64_t* order, uint64_t* levels, uint64_t* depth);
+
+/* toposort_sort and toposort_sort64 that also fill stats (if not NULL) */
+toposort_status toposort_sort_stats(uint32_t n, const uint64_t* offsets, const uint32_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint32_t* order, uint32_t* levels, toposort_stats* stats);
+toposort_status toposort_sort64_stats(uint64_t n, const uint64_t* offsets, const uint64_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint64_t* order, uint64_t* levels, toposort_stats* stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* TOPOSORT_H */
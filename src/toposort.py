@@ -0,0 +1,138 @@
+"""Python bindings of libtoposort.so (toposort.h), build it with `make lib`.
+
+	import numpy as np, toposort
+	order, levels, stats = toposort.sort(offsets, targets, engine='levels', threads=4)
+
+offsets (n+1 entries) and targets are CSR arrays: the children of node v are
+targets[offsets[v]:offsets[v+1]]. Anything with the buffer protocol works.
+Arrays of uint64/int64 offsets with uint32/int32 or uint64/int64 targets are
+passed to the library in place, without a copy; other types are converted
+once. The library call releases the GIL, so other Python threads keep
+running while the parallel sort works.
+
+The library is looked up in $TOPOSORT_LIBRARY, then next to this file.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+API_VERSION = 2
+
+ENGINES = ('serial', 'levels', 'chains', 'components')
+ENGINES64 = ('serial', 'levels')
+
+OK, EINVAL, ECYCLE, EENGINE = 0, 1, 2, 3
+
+
+class Stats(ctypes.Structure):
+	_fields_ = [('seconds', ctypes.c_double),
+				('nodes', ctypes.c_uint64),
+				('edges', ctypes.c_uint64),
+				('depth', ctypes.c_uint64),
+				('threads', ctypes.c_int),
+				('super_nodes', ctypes.c_uint64),
+				('components', ctypes.c_uint64)]
+
+	def asdict(self):
+		return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+class CycleError(RuntimeError):
+	"""The graph has a cycle. order holds the part that could be sorted, all ones after it."""
+	def __init__(self, message, order, levels, stats):
+		RuntimeError.__init__(self, message)
+		self.order = order
+		self.levels = levels
+		self.stats = stats
+
+
+def _load():
+	path = os.environ.get('TOPOSORT_LIBRARY', os.path.join(os.path.dirname(os.path.abspath(__file__)), 'libtoposort.so'))
+	lib = ctypes.CDLL(path) # CDLL drops the GIL during calls
+	u32p = ctypes.POINTER(ctypes.c_uint32)
+	u64p = ctypes.POINTER(ctypes.c_uint64)
+	lib.toposort_api_version.restype = ctypes.c_int
+	lib.toposort_strerror.restype = ctypes.c_char_p
+	lib.toposort_strerror.argtypes = [ctypes.c_int]
+	lib.toposort_sort_stats.restype = ctypes.c_int
+	lib.toposort_sort_stats.argtypes = [ctypes.c_uint32, u64p, u32p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int,
+		u32p, u32p, ctypes.POINTER(Stats)]
+	lib.toposort_sort64_stats.restype = ctypes.c_int
+	lib.toposort_sort64_stats.argtypes = [ctypes.c_uint64, u64p, u64p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int,
+		u64p, u64p, ctypes.POINTER(Stats)]
+	if lib.toposort_api_version() < API_VERSION:
+		raise ImportError('{0} has API version {1}, need {2}'.format(path, lib.toposort_api_version(), API_VERSION))
+	return lib
+
+_lib = _load()
+
+
+def _view(buf, dtype):
+	"""buf as a contiguous array of dtype, the same memory if the width matches"""
+	a = np.asarray(buf) # buffer protocol, no copy
+	if a.dtype.itemsize == np.dtype(dtype).itemsize and a.dtype.kind in 'iu' and a.flags['C_CONTIGUOUS']:
+		return a.view(dtype)
+	return np.ascontiguousarray(a, dtype=dtype)
+
+
+def _ptr(a, ctype):
+	return a.ctypes.data_as(ctypes.POINTER(ctype))
+
+
+def sort(offsets, targets, engine='levels', threads=0, levels=True, validate=True):
+	"""Topological sort of the CSR graph (offsets, targets).
+
+	engine:   'serial', 'levels', 'chains' or 'components' (see toposort.h)
+	threads:  threads of the parallel engines, 0 for the OpenMP default
+	levels:   also return the level of every node
+	validate: check the arrays first, a malformed graph raises ValueError instead of crashing
+
+	Returns (order, levels or None, stats dict). order and levels are new
+	arrays of the width of the ids (uint32 or uint64). Raises CycleError if
+	the graph is not acyclic.
+	"""
+	offsets = _view(offsets, np.uint64)
+	n = offsets.size - 1
+	if n < 0:
+		raise ValueError('offsets needs n+1 entries')
+	wide = n >= 2**32 or np.asarray(targets).dtype.itemsize == 8
+	if wide:
+		if engine not in ENGINES64:
+			raise ValueError('engine {0} has no 64 bit version, use one of {1}'.format(engine, ENGINES64))
+		targets = _view(targets, np.uint64)
+		dtype, ctype, call = np.uint64, ctypes.c_uint64, _lib.toposort_sort64_stats
+	else:
+		targets = _view(targets, np.uint32)
+		dtype, ctype, call = np.uint32, ctypes.c_uint32, _lib.toposort_sort_stats
+	if targets.size < offsets[-1]:
+		raise ValueError('targets has fewer than offsets[n] entries')
+
+	order = np.empty(n, dtype=dtype)
+	lv = np.empty(n, dtype=dtype) if levels else None
+	stats = Stats()
+	status = call(n, _ptr(offsets, ctypes.c_uint64), _ptr(targets, ctype), engine.encode(), threads, int(validate),
+		_ptr(order, ctype), _ptr(lv, ctype) if levels else None, ctypes.byref(stats))
+
+	if status == EINVAL:
+		raise ValueError(_lib.toposort_strerror(status).decode())
+	if status == EENGINE:
+		raise ValueError('unknown engine {0}'.format(engine))
+	if status == ECYCLE:
+		order[stats.nodes:] = np.iinfo(dtype).max
+		raise CycleError(_lib.toposort_strerror(status).decode(), order, lv, stats.asdict())
+	return order, lv, stats.asdict()
+
+
+def from_edges(sources, destinations, n=None):
+	"""CSR arrays (offsets, targets) of the edge list sources[i] -> destinations[i]"""
+	sources = np.asarray(sources)
+	destinations = np.asarray(destinations)
+	if n is None:
+		n = int(max(sources.max(initial=-1), destinations.max(initial=-1))) + 1
+	perm = np.argsort(sources, kind='stable')
+	offsets = np.zeros(n + 1, dtype=np.uint64)
+	np.cumsum(np.bincount(sources, minlength=n), out=offsets[1:])
+	targets = destinations[perm].astype(np.uint32 if n < 2**32 else np.uint64)
+	return offsets, targets
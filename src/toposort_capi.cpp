@@ -0,0 +1,146 @@
+#include "toposort.h"
+
+#include <cstring>
+#include <string>
+#include <omp.h>
+
+#include "topology.hpp"
+#include "sortstate.hpp"
+#include "csrsort.hpp"
+#include "chains.hpp"
+#include "components.hpp"
+
+// component size from which components::sort uses all threads (TOPOSORT_WCC_PARALLEL of csr_components)
+static const topology::type_index componentThreshold = 65536;
+
+// POST:	true if the offsets increase from 0 and every target is < n
+template <typename Index>
+static bool validCSR(Index n, const uint64_t* offsets, const Index* targets) {
+	if(offsets[0] != 0) return false;
+	bool valid = true;
+	#pragma omp parallel for schedule(static) reduction(&&:valid)
+	for(Index v = 0; v < n; ++v) {
+		valid = valid && offsets[v] <= offsets[v+1];
+	}
+	if(!valid) return false;
+	const uint64_t m = offsets[n];
+	#pragma omp parallel for schedule(static) reduction(&&:valid)
+	for(uint64_t e = 0; e < m; ++e) {
+		valid = valid && targets[e] < n;
+	}
+	return valid;
+}
+
+// Copies the result of st to the buffers of the caller
+template <typename State, typename Index>
+static toposort_status publish(const State& st, Index n, Index* order, Index* levels) {
+	const Index nOrdered = st.size();
+	const Index* src = st.order().data();
+	#pragma omp parallel for schedule(static)
+	for(Index i = 0; i < nOrdered; ++i) {
+		order[i] = src[i];
+	}
+	if(levels) {
+		std::memcpy(levels, st.levels().data(), sizeof(Index) * n);
+	}
+	return nOrdered == n ? TOPOSORT_OK : TOPOSORT_ECYCLE;
+}
+
+template <typename Index>
+static void fillStats(toposort_stats* stats, double start, Index nOrdered, uint64_t nEdges, Index depth, int nThreads) {
+	if(!stats) return;
+	stats->seconds = omp_get_wtime() - start;
+	stats->nodes = nOrdered;
+	stats->edges = nEdges;
+	stats->depth = depth;
+	stats->threads = nThreads;
+}
+
+extern "C" {
+
+int toposort_api_version(void) {
+	return TOPOSORT_API_VERSION;
+}
+
+const char* toposort_strerror(toposort_status status) {
+	switch(status) {
+		case TOPOSORT_OK:		return "success";
+		case TOPOSORT_EINVAL:	return "invalid CSR arrays";
+		case TOPOSORT_ECYCLE:	return "graph has a cycle";
+		case TOPOSORT_EENGINE:	return "unknown engine";
+	}
+	return "unknown status";
+}
+
+toposort_status toposort_sort_stats(uint32_t n, const uint64_t* offsets, const uint32_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint32_t* order, uint32_t* levels, toposort_stats* stats) {
+
+	if(stats) std::memset(stats, 0, sizeof(toposort_stats));
+	if(!offsets || !order || (!targets && n > 0 && offsets[n] > 0)) return TOPOSORT_EINVAL;
+	if(validate && !validCSR<uint32_t>(n, offsets, targets)) return TOPOSORT_EINVAL;
+	const std::string name = engine ? engine : "levels";
+	if(name != "serial" && name != "levels" && name != "chains" && name != "components") return TOPOSORT_EENGINE;
+	if(nThreads <= 0) nThreads = omp_get_max_threads();
+
+	const double start = omp_get_wtime();
+	const topology topo(n, offsets, targets);
+	sortState st(topo);
+	topology::type_index depth = 0;
+	if(name == "serial") {
+		depth = csrsort::serial(st);
+		nThreads = 1;
+	} else if(name == "levels") {
+		depth = csrsort::levels(st, nThreads);
+	} else if(name == "chains") {
+		chains::contraction con(topo, nThreads);
+		depth = chains::sort(con, st, nThreads);
+		if(stats) stats->super_nodes = con.contracted().size();
+	} else {
+		components::decomposition dec(topo, nThreads);
+		depth = components::sort(dec, st, componentThreshold, nThreads);
+		if(stats) stats->components = dec.count();
+	}
+	fillStats(stats, start, st.size(), offsets[n], depth, nThreads);
+	return publish(st, n, order, levels);
+}
+
+toposort_status toposort_sort64_stats(uint64_t n, const uint64_t* offsets, const uint64_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint64_t* order, uint64_t* levels, toposort_stats* stats) {
+
+	if(stats) std::memset(stats, 0, sizeof(toposort_stats));
+	if(!offsets || !order || (!targets && n > 0 && offsets[n] > 0)) return TOPOSORT_EINVAL;
+	if(validate && !validCSR<uint64_t>(n, offsets, targets)) return TOPOSORT_EINVAL;
+	const std::string name = engine ? engine : "levels";
+	if(name != "serial" && name != "levels") return TOPOSORT_EENGINE;
+	if(nThreads <= 0) nThreads = omp_get_max_threads();
+	if(name == "serial") nThreads = 1;
+
+	const double start = omp_get_wtime();
+	const topology64 topo(n, offsets, targets);
+	sortState64 st(topo);
+	const topology64::type_index depth = name == "serial" ? csrsort::serial(st) : csrsort::levels(st, nThreads);
+	fillStats(stats, start, st.size(), offsets[n], depth, nThreads);
+	return publish(st, n, order, levels);
+}
+
+toposort_status toposort_sort(uint32_t n, const uint64_t* offsets, const uint32_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint32_t* order, uint32_t* levels, uint32_t* depth) {
+	toposort_stats stats;
+	const toposort_status status = toposort_sort_stats(n, offsets, targets, engine, nThreads, validate, order, levels, &stats);
+	if(depth) *depth = static_cast<uint32_t>(stats.depth);
+	return status;
+}
+
+toposort_status toposort_sort64(uint64_t n, const uint64_t* offsets, const uint64_t* targets,
+	const char* engine, int nThreads, int validate,
+	uint64_t* order, uint64_t* levels, uint64_t* depth) {
+	toposort_stats stats;
+	const toposort_status status = toposort_sort64_stats(n, offsets, targets, engine, nThreads, validate, order, levels, &stats);
+	if(depth) *depth = stats.depth;
+	return status;
+}
+
+} // extern "C"
@@ -0,0 +1,117 @@
+#include "trace.hpp"
+
+#if ENABLE_TRACE == 1
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <map>
+
+
+std::uint64_t tracer::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <class F>
+void tracer::forEachEvent(F f) const {
+	for(std::size_t tid = 0; tid < buffers_.size(); ++tid) {
+		const ringbuffer& rb = buffers_[tid];
+		std::uint64_t first = rb.head_ > TRACE_BUFFERSIZE ? rb.head_ - TRACE_BUFFERSIZE : 0;
+		for(std::uint64_t i = first; i < rb.head_; ++i) {
+			f(tid, rb.events_[i & (TRACE_BUFFERSIZE-1)]);
+		}
+	}
+}
+
+bool tracer::writeChromeTrace(const std::string& filename) const {
+
+	std::uint64_t t0 = std::numeric_limits<std::uint64_t>::max();
+	std::uint64_t dropped = 0;
+	forEachEvent([&](std::size_t, const traceevent& ev) { t0 = std::min(t0, ev.ts_); });
+	for(const ringbuffer& rb : buffers_) {
+		if(rb.head_ > TRACE_BUFFERSIZE) dropped += rb.head_ - TRACE_BUFFERSIZE;
+	}
+
+	std::ofstream f(filename);
+	if(!f) {
+		std::cerr << "Could not open file " << filename << std::endl;
+		return false;
+	}
+
+	f << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool firstEvent = true;
+	forEachEvent([&](std::size_t tid, const traceevent& ev) {
+		if(!firstEvent) f << ",\n";
+		firstEvent = false;
+		f << "{\"pid\":0,\"tid\":" << tid << ",\"ts\":" << std::fixed << std::setprecision(3) << (ev.ts_ - t0) * 1e-3 << ",";
+		switch(ev.type_) {
+			case LEVELBEGIN:	f << "\"ph\":\"B\",\"name\":\"level\",\"args\":{\"level\":" << ev.level_ << "}}"; break;
+			case LEVELEND:		f << "\"ph\":\"E\",\"name\":\"level\",\"args\":{\"nodes\":" << ev.value_ << "}}"; break;
+			case FRONTIER:		f << "\"ph\":\"C\",\"name\":\"frontier\",\"args\":{\"nodes\":" << ev.value_ << "}}"; break;
+			case STEALATTEMPT:	f << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"steal attempt\",\"args\":{\"victim\":" << ev.value_ << "}}"; break;
+			case STEALSUCCESS:	f << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"steal success\",\"args\":{\"victim\":" << ev.value_ << "}}"; break;
+			case BARRIERBEGIN:	f << "\"ph\":\"B\",\"name\":\"barrier\"}"; break;
+			case BARRIEREND:	f << "\"ph\":\"E\",\"name\":\"barrier\"}"; break;
+			case CRITICALBEGIN:	f << "\"ph\":\"B\",\"name\":\"critical\"}"; break;
+			case CRITICALEND:	f << "\"ph\":\"E\",\"name\":\"critical\"}"; break;
+			default:			f << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"unknown\"}";
+		}
+	});
+	f << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+
+	if(dropped > 0)
+		std::cout << "Trace ring buffers overflowed, " << dropped << " oldest events dropped\n";
+	std::cout << "Trace written to: " << filename << std::endl;
+	return true;
+}
+
+bool tracer::writeLevelStatistics(const std::string& filename) const {
+
+	struct levelstat {
+		levelstat() : frontier_(0), begin_(std::numeric_limits<std::uint64_t>::max()), end_(0), work_() {}
+		type_value frontier_;
+		std::uint64_t begin_;
+		std::uint64_t end_;
+		std::vector<type_value> work_; // nodes processed per thread
+	};
+
+	const std::size_t nThreads = buffers_.size();
+	std::map<type_level, levelstat> levels;
+	forEachEvent([&](std::size_t tid, const traceevent& ev) {
+		if(ev.type_ != LEVELBEGIN && ev.type_ != LEVELEND && ev.type_ != FRONTIER) return;
+		levelstat& ls = levels[ev.level_];
+		if(ls.work_.empty()) ls.work_.resize(nThreads, 0);
+		switch(ev.type_) {
+			case LEVELBEGIN:	ls.begin_ = std::min(ls.begin_, ev.ts_); break;
+			case LEVELEND:		ls.end_ = std::max(ls.end_, ev.ts_); ls.work_[tid] += ev.value_; break;
+			case FRONTIER:		ls.frontier_ = ev.value_; break;
+		}
+	});
+
+	std::ofstream f(filename);
+	if(!f) {
+		std::cerr << "Could not open file " << filename << std::endl;
+		return false;
+	}
+	// imbalance = maxWork/meanWork, 1 is perfectly balanced
+	f << "level,frontier,maxWork,meanWork,imbalance,duration_us\n";
+	for(const auto& lv : levels) {
+		const levelstat& ls = lv.second;
+		type_value maxWork = *std::max_element(ls.work_.begin(), ls.work_.end());
+		type_value totalWork = 0;
+		for(auto w : ls.work_) totalWork += w;
+		double meanWork = static_cast<double>(totalWork) / nThreads;
+		type_value frontier = ls.frontier_ > 0 ? ls.frontier_ : totalWork; // engines without a global frontier
+		double duration = (ls.end_ > ls.begin_) ? (ls.end_ - ls.begin_) * 1e-3 : 0.;
+		f << lv.first << "," << frontier << "," << maxWork << "," << meanWork << ","
+		  << (meanWork > 0 ? maxWork / meanWork : 0.) << "," << duration << "\n";
+	}
+
+	std::cout << "Level statistics written to: " << filename << std::endl;
+	return true;
+}
+
+#endif // ENABLE_TRACE == 1
@@ -0,0 +1,106 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+
+// Timeline tracing of per-thread activity (build with TRACE=1, -DENABLE_TRACE=1).
+//
+// Every thread writes timestamped events into its own ring buffer, so tracing
+// needs no synchronization and the oldest events are overwritten once a
+// buffer is full. The buffers are exported as Chrome trace / Perfetto JSON
+// (load in chrome://tracing or ui.perfetto.dev) and summarized per level.
+// Without ENABLE_TRACE all calls are empty inline functions.
+
+#ifndef TRACE_BUFFERSIZE
+#define TRACE_BUFFERSIZE (1 << 18) // events per thread, must be a power of two
+#endif
+
+class tracer {
+
+	public:
+
+		enum eventtype {LEVELBEGIN,		// level = level
+						LEVELEND,		// level = level, value = nodes processed by the thread in this level
+						FRONTIER,		// level = level, value = number of nodes in the frontier
+						STEALATTEMPT,	// value = victim thread
+						STEALSUCCESS,	// value = victim thread
+						BARRIERBEGIN,
+						BARRIEREND,
+						CRITICALBEGIN,
+						CRITICALEND,
+						N_EVENTTYPE};
+
+		using type_threadcount = short;
+		using type_level = std::uint32_t;
+		using type_value = std::uint64_t;
+
+#if ENABLE_TRACE == 1
+
+		tracer()
+			: buffers_()
+		{}
+
+		// PRE:		must be called single threaded before the first event
+		// POST:	one empty ring buffer per thread
+		void init(type_threadcount nThreads) {
+			buffers_ = type_buffers(nThreads);
+		}
+
+		// PRE:		called by thread tid
+		inline void event(type_threadcount tid, eventtype type, type_level level = 0, type_value value = 0) {
+			ringbuffer& rb = buffers_[tid];
+			traceevent& ev = rb.events_[rb.head_ & (TRACE_BUFFERSIZE-1)];
+			ev.ts_ = now();
+			ev.type_ = type;
+			ev.level_ = level;
+			ev.value_ = value;
+			++rb.head_;
+		}
+
+		bool writeChromeTrace(const std::string& filename) const;
+		bool writeLevelStatistics(const std::string& filename) const;
+
+	private:
+
+		struct traceevent {
+			std::uint64_t ts_; // nanoseconds
+			std::uint32_t type_;
+			type_level level_;
+			type_value value_;
+		};
+
+		// aligned to a cache line so that the heads of different threads do not share one
+		struct alignas(util::cacheline) ringbuffer {
+			ringbuffer()
+				: head_(0)
+				, events_(TRACE_BUFFERSIZE)
+			{}
+			std::uint64_t head_; // number of events ever written
+			std::vector<traceevent> events_;
+		};
+
+		static std::uint64_t now();
+
+		// calls f(tid,event) for all retained events in chronological order per thread
+		template <class F>
+		void forEachEvent(F f) const;
+
+		using type_buffers = std::vector<ringbuffer, util::aligned_allocator<ringbuffer> >;
+		type_buffers buffers_;
+
+#else // declare empty inline functions - they will disappear
+
+		inline void init(type_threadcount nThreads) {}
+		inline void event(type_threadcount tid, eventtype type, type_level level = 0, type_value value = 0) {}
+		inline bool writeChromeTrace(const std::string& filename) const { return true; }
+		inline bool writeLevelStatistics(const std::string& filename) const { return true; }
+
+#endif // ENABLE_TRACE == 1
+
+};
+
+#endif // TRACE_HPP
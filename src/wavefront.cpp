@@ -0,0 +1,88 @@
+#include "wavefront.hpp"
+#include "scan.hpp"
+
+#include <algorithm>
+#include <omp.h>
+
+namespace wavefront {
+
+	template <typename Index>
+	void fromLevels(const Index* level, Index N, Index depth, basic_levelCSR<Index>& out, int nThreads) {
+		out.offsets_.assign(depth, 0);
+		out.nodes_.resize(N);
+		if(depth == 0) {
+			out.offsets_.push_back(0);
+			return;
+		}
+		if(nThreads <= 0) nThreads = omp_get_max_threads();
+		// a histogram per thread and level, deep graphs with few nodes per level use one thread
+		if(static_cast<std::uint64_t>(depth) * nThreads > static_cast<std::uint64_t>(N) + 65536) nThreads = 1;
+
+		std::vector<std::vector<Index>> count(nThreads);	// [thread][level], then the first slot of the thread in the level
+		std::vector<Index> sums(nThreads + 1);
+
+		#pragma omp parallel num_threads(nThreads)
+		{
+			const Index tid = omp_get_thread_num();
+			const Index team = omp_get_num_threads();
+			const Index first = N / team * tid + std::min(tid, N % team);
+			const Index last = first + N / team + (tid < N % team ? 1 : 0);
+
+			std::vector<Index>& mine = count[tid];
+			mine.assign(depth, 0);
+			for(Index v = first; v < last; ++v) ++mine[level[v]];
+			#pragma omp barrier
+
+			// level sizes, every thread sums a range of levels
+			#pragma omp for schedule(static)
+			for(Index k = 0; k < depth; ++k) {
+				Index size = 0;
+				for(Index t = 0; t < team; ++t) size += count[t][k];
+				out.offsets_[k] = size;
+			}
+			const Index total = scan::exclusive(out.offsets_, sums);
+
+			// within a level, thread t writes after threads 0..t-1: ids stay ascending
+			#pragma omp for schedule(static)
+			for(Index k = 0; k < depth; ++k) {
+				Index slot = out.offsets_[k];
+				for(Index t = 0; t < team; ++t) {
+					const Index c = count[t][k];
+					count[t][k] = slot;
+					slot += c;
+				}
+			} // implicit barrier
+
+			for(Index v = first; v < last; ++v) out.nodes_[mine[level[v]]++] = v;
+
+			#pragma omp single
+			out.offsets_.push_back(total);
+		} // end of OMP parallel
+	}
+
+	template <typename Index>
+	statistics summarize(const basic_levelCSR<Index>& waves) {
+		statistics s;
+		const Index D = waves.depth();
+		if(D == 0) return s;
+		std::vector<Index> sizes(D);
+		for(Index k = 0; k < D; ++k) {
+			sizes[k] = waves.size(k);
+			if(sizes[k] == 1) ++s.singletons_;
+		}
+		s.depth_ = D;
+		s.mean_ = static_cast<double>(waves.nodes_.size()) / D;
+		std::nth_element(sizes.begin(), sizes.begin() + D / 2, sizes.end());
+		s.median_ = sizes[D / 2];
+		const auto range = std::minmax_element(sizes.begin(), sizes.end());
+		s.min_ = *range.first;
+		s.max_ = *range.second;
+		return s;
+	}
+
+	template void fromLevels(const std::uint32_t*, std::uint32_t, std::uint32_t, basic_levelCSR<std::uint32_t>&, int);
+	template void fromLevels(const std::uint64_t*, std::uint64_t, std::uint64_t, basic_levelCSR<std::uint64_t>&, int);
+	template statistics summarize(const basic_levelCSR<std::uint32_t>&);
+	template statistics summarize(const basic_levelCSR<std::uint64_t>&);
+
+} // end namespace wavefront
@@ -0,0 +1,94 @@
+#ifndef WAVEFRONT_HPP
+#define WAVEFRONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sink.hpp"
+
+// The order grouped by level, as a CSR structure: wave k holds the nodes
+// whose longest path from a source has k edges, they can all run at the
+// same time once waves 0..k-1 are done.
+//
+//   nodes_[offsets_[k]] ... nodes_[offsets_[k+1]-1]	the nodes of wave k
+namespace wavefront {
+
+	template <typename Index>
+	struct basic_levelCSR {
+
+		std::vector<Index> offsets_;	// depth()+1 entries, offsets_[0] = 0
+		std::vector<Index> nodes_;
+
+		inline Index depth() const {
+			return offsets_.empty() ? 0 : offsets_.size() - 1;
+		}
+		inline Index size(Index k) const {
+			return offsets_[k + 1] - offsets_[k];
+		}
+		inline const Index* begin(Index k) const {
+			return nodes_.data() + offsets_[k];
+		}
+		inline const Index* end(Index k) const {
+			return nodes_.data() + offsets_[k + 1];
+		}
+	};
+
+	// Counting sort of the nodes by level in an OpenMP team of nThreads (0: omp_get_max_threads()):
+	// per-thread histograms, prefix sums per level over the threads, scatter.
+	// Within a wave the ids are ascending. For any engine that fills the levels.
+	// PRE:		level[v] < depth for all N nodes (a complete sort)
+	// POST:	out holds the waves
+	template <typename Index>
+	void fromLevels(const Index* level, Index N, Index depth, basic_levelCSR<Index>& out, int nThreads = 0);
+
+	// Builds the waves while a level-grouped sort (csrsort::levels) hands over its levels:
+	// the offsets are the running sum of the level sizes, the ids are copied as they arrive.
+	template <typename Index>
+	class basic_collector : public sink::basic_levelSink<Index> {
+
+		public:
+
+			// POST:	out is empty, with room for N nodes
+			basic_collector(basic_levelCSR<Index>& out, Index N)
+				:	out_(out)
+			{
+				out_.offsets_.assign(1, 0);
+				out_.nodes_.clear();
+				out_.nodes_.reserve(N);
+			}
+
+			bool level(Index level, const Index* nodes, std::size_t n) override {
+				if(level + 1 != out_.offsets_.size()) return false; // a level is missing
+				out_.nodes_.insert(out_.nodes_.end(), nodes, nodes + n);
+				out_.offsets_.push_back(out_.nodes_.size());
+				return true;
+			}
+
+		private:
+
+			basic_levelCSR<Index>& out_;
+	};
+
+	// Level sizes, for the analysis output
+	struct statistics {
+		std::size_t depth_ = 0;
+		std::size_t min_ = 0;
+		std::size_t max_ = 0;
+		std::size_t median_ = 0;
+		double mean_ = 0;
+		std::size_t singletons_ = 0;	// waves of a single node, no parallelism at all
+	};
+
+	template <typename Index>
+	statistics summarize(const basic_levelCSR<Index>& waves);
+
+	// ids of topology and topology32, and of topology64, instantiated in wavefront.cpp
+	using levelCSR = basic_levelCSR<std::uint32_t>;
+	using collector = basic_collector<std::uint32_t>;
+	using levelCSR64 = basic_levelCSR<std::uint64_t>;
+	using collector64 = basic_collector<std::uint64_t>;
+
+} // end namespace wavefront
+
+#endif // WAVEFRONT_HPP